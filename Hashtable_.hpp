@@ -4,6 +4,33 @@
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <iterator>
+#include <utility>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <new>
+#include <atomic>
+#include <random>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
 
 namespace Hashtable
 {
@@ -17,14 +44,18 @@ class Hashing
     virtual void clear() = 0;
 
  protected:
+    // The full hashes are kept unreduced so that tables can store them next to
+    // their keys: entries with different hashes never need a key comparison,
+    // and an entry can be moved to another bucket without hashing its key again.
+
     // generic hash function for all type
-    template<typename T> static constexpr size_type Hash_Function(const T& value)
+    template<typename T> static constexpr size_type Full_Hash(const T& value)
     {
-        return static_cast<size_type>(value) % N;
+        return static_cast<size_type>(value);
     }
 
     // specific hash functions for string type
-    static constexpr size_type Hash_Function(const std::string& value)
+    static constexpr size_type Full_Hash(const std::string& value)
     {
         using std::pow;
         constexpr short unsigned prime_chosen = 263;
@@ -34,782 +65,4202 @@ class Hashing
         for(auto&& it : value){
             hash += ((prime_chosen * carol_prime) ^ (prime_chosen * hash + it)) % carol_prime;
         }
-        return hash % N;
+        return static_cast<size_type>(hash);
     }
 
     // specific hash functions for char type
-    static constexpr size_type Hash_Function(const char& value)
+    static constexpr size_type Full_Hash(const char& value)
     {
         unsigned int hash = 0xAAAAAAAA;
-        return ((value & 1) == 0) ? (  (hash << 7) ^ (value) * (hash >> 3)) % N
-                                  : (~((hash << 11) + (value ^ (hash >> 5)) ))  % N;
+        return ((value & 1) == 0) ? (  (hash << 7) ^ (value) * (hash >> 3))
+                                  : (~((hash << 11) + (value ^ (hash >> 5)) ));
     }
 
-    static constexpr size_type Hash_Function(const unsigned char& value)
+    static constexpr size_type Full_Hash(const unsigned char& value)
     {
         unsigned int hash = 0xAAAAAAAA;
-        return ((value & 1) == 0) ? (  (hash << 7) ^ (value) * (hash >> 3)) % N
-                                  : (~((hash << 11) + (value ^ (hash >> 5)) ))  % N;
+        return ((value & 1) == 0) ? (  (hash << 7) ^ (value) * (hash >> 3))
+                                  : (~((hash << 11) + (value ^ (hash >> 5)) ));
     }
 
-    static constexpr size_type Hash_Function(const signed char& value)
+    static constexpr size_type Full_Hash(const signed char& value)
     {
         unsigned int hash = 0xAAAAAAAA;
-        return ((value & 1) == 0) ? (  (hash << 7) ^ (value) * (hash >> 3)) % N
-                                  : (~((hash << 11) + (value ^ (hash >> 5)) ))  % N;
+        return ((value & 1) == 0) ? (  (hash << 7) ^ (value) * (hash >> 3))
+                                  : (~((hash << 11) + (value ^ (hash >> 5)) ));
     }
-};
 
-template<typename _Tp, std::size_t N = 100>
-class Hashtable_Chaining : public Hashing<_Tp, N>
-{
- public:
-    using value_type = _Tp;
-    using reference = _Tp&;
-    using const_reference = const _Tp&;
-    using size_type = std::size_t;
+    // heap bytes owned by a key besides the key object itself
+    template<typename T> static size_type External_Bytes(const T&)
+    {
+        return 0;
+    }
 
- private:
-    class DoublyLinkedList
+    static size_type External_Bytes(const std::string& value)
     {
-    public:
-        class Node
-        {
-        public:
-            using Node_pointer = Node*;
-            using Const_Node_ptr = const Node*;
+        const char* object = reinterpret_cast<const char*>(&value);
+        bool inline_buffer = value.data() >= object && value.data() < object + sizeof(value);
+        return (inline_buffer) ? 0 : value.capacity() + 1;
+    }
 
-        private:
-            Node_pointer next;
-            Node_pointer prev;
-            value_type* key;
+    // Seeded hashes, for tables whose keys may come from untrusted clients: with a secret seed per
+    // table nobody can choose keys that collide. Strings fold the seed into every 8-byte word;
+    // other keys have their full hash remixed with the seed. This is collision resistance against
+    // an attacker who cannot see the seed, not a cryptographic MAC.
+    static constexpr std::uint64_t Mix_Hash(std::uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
 
-        public:
-            constexpr Node() : next(nullptr), prev(nullptr), key(nullptr) {}
+    template<typename T> static size_type Seeded_Hash(const T& value, size_type seed)
+    {
+        return static_cast<size_type>(Mix_Hash(static_cast<std::uint64_t>(Full_Hash(value)) ^ seed));
+    }
 
-            constexpr Node(value_type _key) : Node() { key = new value_type(_key); }
+    static size_type Seeded_Hash(const std::string& value, size_type seed)
+    {
+        std::uint64_t hash = seed ^ (value.size() * 0x9E3779B97F4A7C15ULL);
+        size_type i = 0;
 
-            Node(const Node& other) : next(other.next), prev(other.prev), key(nullptr)
-            {
-                if(other.key) {
-                    key = new value_type(*other.key);
-                }
-            }
+        for(; i + sizeof(std::uint64_t) <= value.size(); i += sizeof(std::uint64_t))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, value.data() + i, sizeof(word));
+            hash = Mix_Hash(hash ^ word);
+        }
 
-            constexpr Node(Node&& other) noexcept : next(std::move(other.next)), prev(std::move(other.prev)), key(std::move(other.key)) {}
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, value.data() + i, value.size() - i);
+        return static_cast<size_type>(Mix_Hash(hash ^ tail ^ seed));
+    }
 
-            constexpr Node& operator=(const Node& other)
-            {
-                if(this == &other) {
-                    return (*this);
-                }
+    // a different seed on every call: the process draws from std::random_device once and each
+    // call then remixes the next value of a counter
+    static size_type Random_Seed()
+    {
+        static const std::uint64_t base = (static_cast<std::uint64_t>(std::random_device()()) << 32) ^ std::random_device()();
+        static std::atomic<std::uint64_t> sequence(0);
+        return static_cast<size_type>(Mix_Hash(base + sequence.fetch_add(0x9E3779B97F4A7C15ULL)));
+    }
 
-                this->~Node();
-                next = other.next;
-                prev = other.prev;
+    // reduce a full hash to a bucket index
+    static constexpr size_type Hash_Index(size_type hash)
+    {
+        return hash % N;
+    }
 
-                if(other.key){
-                    key = new value_type(*other.key);
-                } else {
-                    key = nullptr;
-                }
-                return (*this);
-            }
+    template<typename T> static constexpr size_type Hash_Function(const T& value)
+    {
+        return Hash_Index(Full_Hash(value));
+    }
+};
 
-            constexpr Node& operator=(Node&& other) noexcept
-            {
-                this->~Node();
+// Allocation hook for the bucket and slot arrays of the tables, and for the nodes and keys of
+// Hashtable_Chaining. Keys of the generic Hashtable_Probing are boxed with operator new, and heap
+// memory owned by keys themselves (string buffers), sorted bucket indexes and filters are never
+// taken from the resource. A table keeps the resource it was constructed with (copies share it),
+// so a resource can account for or limit a group of tables; copy assignment keeps it too, only
+// move assignment takes over the other table's memory and resource.
+// A copy of a table may release shared memory on another thread, so a resource shared by tables
+// used on several threads must be safe to call concurrently; the resources below all are.
+class Memory_Resource
+{
+ public:
+    using size_type = std::size_t;
 
-                next = other.next;
-                prev = other.prev;
-                key = other.key;
+    virtual ~Memory_Resource() {}
 
-                other.next = nullptr;
-                other.prev = nullptr;
-                other.key = nullptr;
-                return (*this);
-            }
+    virtual void* allocate(size_type bytes, size_type alignment) = 0;
+    virtual void deallocate(void* pointer, size_type bytes, size_type alignment) = 0;
 
-            virtual ~Node()
+    // plain operator new / operator delete, used when a table is given no resource
+    static Memory_Resource* default_resource()
+    {
+        class New_Delete_Resource : public Memory_Resource
+        {
+         public:
+            void* allocate(size_type bytes, size_type) override
             {
-                clear();
+                return ::operator new(bytes);
             }
 
-            constexpr void setKey(value_type _key)
+            void deallocate(void* pointer, size_type, size_type) override
             {
-                if(!key){
-                    key = new value_type(_key);
-                }
-                else{
-                    *key = _key;
-                }
+                ::operator delete(pointer);
             }
+        };
 
-            constexpr reference getKey()
-            {
-                return *key;
-            }
+        static New_Delete_Resource resource;
+        return &resource;
+    }
 
-            constexpr const_reference getKey() const
-            {
-                return *key;
-            }
+    // allocate and construct n objects, each from args
+    template<typename T, typename... Args>
+    T* construct_array(size_type n, const Args&... args)
+    {
+        T* array = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        size_type built = 0;
+        try
+        {
+            for(; built < n; ++built)
+                new (array + built) T(args...);
+        }
+        catch(...)
+        {
+            for(; built > 0; --built)
+                array[built - 1].~T();
+            deallocate(array, n * sizeof(T), alignof(T));
+            throw;
+        }
+        return array;
+    }
 
-            constexpr void createNext(value_type _key)
-            {
-                if(next) {
-                    return;
-                }
+    // allocate n objects, copy constructed from source[0, n)
+    template<typename T>
+    T* copy_array(const T* source, size_type n)
+    {
+        T* array = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        size_type built = 0;
+        try
+        {
+            for(; built < n; ++built)
+                new (array + built) T(source[built]);
+        }
+        catch(...)
+        {
+            for(; built > 0; --built)
+                array[built - 1].~T();
+            deallocate(array, n * sizeof(T), alignof(T));
+            throw;
+        }
+        return array;
+    }
 
-                next = new Node(_key);
-                next->prev = this;
-            }
+    template<typename T>
+    void destroy_array(T* array, size_type n)
+    {
+        if(array == nullptr)
+            return;
 
-            constexpr void setNext(const Node_pointer& newNext)
-            {
-                if(next && next->prev == this){
-                    next->prev = nullptr;
-                }
-                next = newNext;
+        for(size_type i = n; i > 0; --i)
+            array[i - 1].~T();
+        deallocate(array, n * sizeof(T), alignof(T));
+    }
+};
 
-                if(newNext){
-                    if(newNext->prev){
-                        newNext->prev->next = nullptr;
-                    }
-                    newNext->prev = this;
-                }
-            }
+// Forwards to another resource and refuses, with std::bad_alloc, any allocation that would take
+// the bytes currently held above the budget.
+class Budget_Resource : public Memory_Resource
+{
+ private:
+    Memory_Resource* upstream;
+    size_type limit;
+    std::atomic<size_type> used;
 
-            constexpr Node_pointer getNext()
-            {
-                return next;
-            }
+ public:
+    explicit Budget_Resource(size_type budget, Memory_Resource* upstream_resource = Memory_Resource::default_resource())
+        : upstream(upstream_resource), limit(budget), used(0) {}
 
-            constexpr Const_Node_ptr getNext() const
-            {
-                return next;
-            }
+    void* allocate(size_type bytes, size_type alignment) override
+    {
+        // claim the bytes before allocating, so concurrent callers cannot overshoot the budget together
+        size_type current = used.load(std::memory_order_relaxed);
+        do
+        {
+            if(bytes > limit - current)
+                throw std::bad_alloc();
+        }
+        while(!used.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
 
-            constexpr void createPrevious(value_type _key)
-            {
-                if(prev) {
-                    return;
-                }
+        try
+        {
+            return upstream->allocate(bytes, alignment);
+        }
+        catch(...)
+        {
+            used.fetch_sub(bytes, std::memory_order_relaxed);
+            throw;
+        }
+    }
 
-                prev = new Node(_key);
-                prev->next = this;
-            }
+    void deallocate(void* pointer, size_type bytes, size_type alignment) override
+    {
+        upstream->deallocate(pointer, bytes, alignment);
+        used.fetch_sub(bytes, std::memory_order_relaxed);
+    }
 
-            constexpr void setPrevious(const Node_pointer& NewPrevious)
-            {
-                if(prev && prev->next == this){
-                    prev->next = nullptr;
-                }
-                prev = NewPrevious;
+    size_type budget() const
+    {
+        return limit;
+    }
 
-                if(NewPrevious){
-                    if(NewPrevious->next){
-                        NewPrevious->next->prev = nullptr;
-                    }
-                    NewPrevious->next = this;
-                }
-            }
+    size_type bytes_used() const
+    {
+        return used.load(std::memory_order_relaxed);
+    }
+};
 
-            constexpr Node_pointer getPrevious()
-            {
-                return prev;
-            }
+// Fixed-size array stored as reference-counted segments, so copying it is O(1): a copy shares
+// the directory and every segment, and the first write through either copy clones just the
+// directory and the segment it touches. Reads go through const operator[] and never copy;
+// all modifications must go through write(). Reference counts are atomic, so a copy can be read
+// and destroyed on another thread while the original keeps being modified, as long as the memory
+// resource is thread-safe (see Memory_Resource).
+// The initial segments are carved from one allocation of the memory resource (which keeps huge
+// page backing effective); segments cloned later are allocated one by one.
+template<typename T>
+class Cow_Array
+{
+ public:
+    using size_type = std::size_t;
 
-            constexpr Const_Node_ptr getPrevious() const
-            {
-                return prev;
-            }
+ private:
+    static constexpr size_type segment_bytes = size_type(1) << 16;
 
-            void clear()
-            {
-                if(key){
-                    delete key;
-                    key = nullptr;
-                }
-                if(next && next->prev == this){
-                    next->prev = nullptr;
-                }
-                if(prev && prev->next == this){
-                    prev->next = nullptr;
-                }
-                prev = next = nullptr;
-            }
-        };
+    static constexpr size_type floor_power_of_two(size_type n, size_type power = 1)
+    {
+        return (power * 2 <= n) ? floor_power_of_two(n, power * 2) : power;
+    }
 
-        using Node_ptr = typename Node::Node_pointer;
-        using ConstNPtr = typename Node::Const_Node_ptr;
+ public:
+    static constexpr size_type segment_length = floor_power_of_two((sizeof(T) < segment_bytes) ? segment_bytes / sizeof(T) : 1);
 
-        constexpr static Node_ptr MakeNode(value_type key)
-        {
-            return new Node(key);
-        }
+ private:
+    // the single allocation behind the initial segments, freed with the last of them
+    struct block
+    {
+        T* items;
+        size_type length;
+        std::atomic<size_type> live_segments;
+    };
 
-    protected:
-        Node_ptr head;
-        Node_ptr tail;
+    struct segment
+    {
+        std::atomic<size_type> refs;
+        T* items;
         size_type length;
+        block* base;
+    };
 
-    public:
-        constexpr DoublyLinkedList() : head(nullptr), tail(nullptr), length(0) {}
+    struct directory
+    {
+        std::atomic<size_type> refs;
+        size_type count;
+        T** items;
+        segment** segments;
+    };
 
-        constexpr DoublyLinkedList(std::initializer_list<value_type> initList) : DoublyLinkedList()
+    directory* dir;
+    size_type length;
+    Memory_Resource* resource;
+
+    static directory* make_directory(size_type count)
+    {
+        directory* result = new directory;
+        result->refs.store(1, std::memory_order_relaxed);
+        result->count = count;
+        result->items = new T*[count];
+        result->segments = new segment*[count];
+        return result;
+    }
+
+    void release_segment(segment* seg)
+    {
+        if(seg->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        if(seg->base)
         {
-            for(auto&& i : initList) {
-                insert(i);
+            for(size_type i = seg->length; i > 0; --i)
+                seg->items[i - 1].~T();
+
+            block* base = seg->base;
+            if(base->live_segments.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                resource->deallocate(base->items, base->length * sizeof(T), alignof(T));
+                delete base;
             }
         }
-
-        constexpr DoublyLinkedList(const DoublyLinkedList& other) : DoublyLinkedList()
+        else
         {
-            if(!other.head){
-                head = tail = nullptr; length = 0;
-                return;
-            }
-            else{
-                head = MakeNode(other.head->getKey());
+            resource->destroy_array(seg->items, seg->length);
+        }
+        delete seg;
+    }
 
-                Node_ptr current = head;
-                Node_ptr other_current = other.head->getNext();
-                while(other_current)
-                {
-                    current->createNext(other_current->getKey());
-                    current = current->getNext();
-                    other_current = other_current->getNext();
-                }
-                tail = current;
-                length = other.length;
-            }
+    void release()
+    {
+        if(!dir || dir->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            dir = nullptr;
+            return;
         }
 
-        constexpr DoublyLinkedList(DoublyLinkedList&& other) noexcept
-            : head(std::move(other.head)), tail(std::move(other.tail)), length(std::move(other.length)) {}
+        for(size_type k = 0; k < dir->count; ++k)
+            release_segment(dir->segments[k]);
+        delete[] dir->items;
+        delete[] dir->segments;
+        delete dir;
+        dir = nullptr;
+    }
 
-        constexpr DoublyLinkedList& operator=(const DoublyLinkedList& other)
+    // split the length elements at items, allocated from resource, into the initial segments
+    void carve(T* items)
+    {
+        size_type count = (length + segment_length - 1) / segment_length;
+        block* base = new block;
+        base->items = items;
+        base->length = length;
+        base->live_segments.store(count, std::memory_order_relaxed);
+
+        dir = make_directory(count);
+        for(size_type k = 0; k < count; ++k)
         {
-            if(this == &other) {
-                    return (*this);
-            }
+            segment* seg = new segment;
+            seg->refs.store(1, std::memory_order_relaxed);
+            seg->items = base->items + k * segment_length;
+            seg->length = (length - k * segment_length < segment_length) ? length - k * segment_length : segment_length;
+            seg->base = base;
+            dir->segments[k] = seg;
+            dir->items[k] = seg->items;
+        }
+    }
 
-            clear();
+ public:
+    Cow_Array() : dir(nullptr), length(0), resource(Memory_Resource::default_resource()) {}
 
-            if(!other.head){
-                return (*this);
-            }
-            else{
-                head = MakeNode(other.head->getKey());
+    // n elements, each constructed from args
+    template<typename... Args>
+    Cow_Array(Memory_Resource* memory, size_type n, const Args&... args) : dir(nullptr), length(n), resource(memory)
+    {
+        carve(resource->construct_array<T>(n, args...));
+    }
 
-                Node_ptr current = head;
-                Node_ptr other_current = other.head->getNext();
-                while(other_current)
-                {
-                    current->createNext(other_current->getKey());
-                    current = current->getNext();
-                    other_current = other_current->getNext();
-                }
-                tail = current;
-                length = other.length;
-                return (*this);
-            }
-        }
+    Cow_Array(const Cow_Array& other) : dir(other.dir), length(other.length), resource(other.resource)
+    {
+        if(dir)
+            dir->refs.fetch_add(1, std::memory_order_relaxed);
+    }
 
-        constexpr DoublyLinkedList& operator=(DoublyLinkedList&& other) noexcept
+    // A copy whose memory comes from memory: it shares the segments of other when other uses the
+    // same resource, and copies the elements into a new allocation of memory otherwise.
+    Cow_Array(const Cow_Array& other, Memory_Resource* memory) : dir(nullptr), length(other.length), resource(memory)
+    {
+        if(other.resource == memory)
+        {
+            dir = other.dir;
+            if(dir)
+                dir->refs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if(!other.dir)
+            return;
+
+        T* items = static_cast<T*>(resource->allocate(length * sizeof(T), alignof(T)));
+        size_type built = 0;
+        try
+        {
+            for(; built < length; ++built)
+                new (items + built) T(other[built]);
+        }
+        catch(...)
+        {
+            for(; built > 0; --built)
+                items[built - 1].~T();
+            resource->deallocate(items, length * sizeof(T), alignof(T));
+            throw;
+        }
+        carve(items);
+    }
+
+    Cow_Array(Cow_Array&& other) noexcept : dir(other.dir), length(other.length), resource(other.resource)
+    {
+        other.dir = nullptr;
+        other.length = 0;
+    }
+
+    Cow_Array& operator=(const Cow_Array& other)
+    {
+        if(this == &other || dir == other.dir)
+            return *this;
+
+        release();
+        dir = other.dir;
+        length = other.length;
+        resource = other.resource;
+        if(dir)
+            dir->refs.fetch_add(1, std::memory_order_relaxed);
+        return *this;
+    }
+
+    Cow_Array& operator=(Cow_Array&& other) noexcept
+    {
+        if(this == &other)
+            return *this;
+
+        release();
+        dir = other.dir;
+        length = other.length;
+        resource = other.resource;
+        other.dir = nullptr;
+        other.length = 0;
+        return *this;
+    }
+
+    ~Cow_Array()
+    {
+        release();
+    }
+
+    const T& operator[](size_type i) const
+    {
+        return dir->items[i / segment_length][i % segment_length];
+    }
+
+    // element i, made private to this array first if it is shared with a copy
+    T& write(size_type i)
+    {
+        if(dir->refs.load(std::memory_order_acquire) != 1)
+        {
+            directory* own = make_directory(dir->count);
+            for(size_type k = 0; k < dir->count; ++k)
+            {
+                dir->segments[k]->refs.fetch_add(1, std::memory_order_relaxed);
+                own->segments[k] = dir->segments[k];
+                own->items[k] = dir->items[k];
+            }
+            release();
+            dir = own;
+        }
+
+        size_type k = i / segment_length;
+        segment* seg = dir->segments[k];
+        if(seg->refs.load(std::memory_order_acquire) != 1)
+        {
+            segment* own = new segment;
+            own->refs.store(1, std::memory_order_relaxed);
+            own->length = seg->length;
+            own->base = nullptr;
+            try
+            {
+                own->items = resource->copy_array(seg->items, seg->length);
+            }
+            catch(...)
+            {
+                delete own;
+                throw;
+            }
+
+            release_segment(seg);
+            dir->segments[k] = own;
+            dir->items[k] = own->items;
+        }
+        return dir->items[k][i % segment_length];
+    }
+
+    size_type size() const
+    {
+        return length;
+    }
+
+    // true while some segment is still shared with a copy
+    bool shared() const
+    {
+        if(!dir)
+            return false;
+        if(dir->refs.load(std::memory_order_acquire) != 1)
+            return true;
+
+        for(size_type k = 0; k < dir->count; ++k)
+        {
+            if(dir->segments[k]->refs.load(std::memory_order_acquire) != 1)
+                return true;
+        }
+        return false;
+    }
+
+    // the elements plus segment bookkeeping; shared segments are counted in full
+    size_type memory_usage() const
+    {
+        if(!dir)
+            return 0;
+
+        return length * sizeof(T) + sizeof(directory) + dir->count * (sizeof(T*) + sizeof(segment*) + sizeof(segment));
+    }
+
+    void swap(Cow_Array& other) noexcept
+    {
+        std::swap(dir, other.dir);
+        std::swap(length, other.length);
+        std::swap(resource, other.resource);
+    }
+};
+
+// Backs large bucket and slot arrays with their own mmap'd regions to cut TLB misses. Explicit
+// huge pages (MAP_HUGETLB) are tried first when requested; without a reserved huge page pool the
+// region falls back to normal pages with a transparent huge page hint (MADV_HUGEPAGE). NUMA
+// placement is applied with mbind and silently skipped when the kernel refuses it. Allocations
+// below min_bytes, and every allocation on systems without mmap, go to the upstream resource.
+class Huge_Page_Resource : public Memory_Resource
+{
+ public:
+    enum class Pages { normal, transparent, explicit_huge };
+    enum class Numa { local, interleave, bind };
+
+    static constexpr size_type huge_page_size = size_type(2) << 20;
+
+ private:
+    Pages pages;
+    Numa numa;
+    unsigned long node_mask;
+    size_type min_bytes;
+    Memory_Resource* upstream;
+    std::atomic<size_type> mapped;
+    std::atomic<size_type> explicit_mapped;
+
+    static size_type round_up(size_type bytes)
+    {
+        return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+    }
+
+#if defined(__linux__)
+    void apply_numa(void* pointer, size_type length) const
+    {
+        // MPOL_INTERLEAVE and MPOL_BIND; a failing mbind just leaves the default first-touch policy
+        if(numa == Numa::local || node_mask == 0)
+            return;
+
+        int mode = (numa == Numa::interleave) ? 3 : 2;
+        syscall(SYS_mbind, pointer, length, mode, &node_mask, sizeof(node_mask) * 8 + 1, 0);
+    }
+#endif
+
+ public:
+    // node_mask selects the NUMA nodes (bit i for node i) used by interleave and bind
+    explicit Huge_Page_Resource(Pages page_mode = Pages::transparent, Numa numa_policy = Numa::local, unsigned long nodes = 0,
+                                size_type threshold = huge_page_size / 2, Memory_Resource* upstream_resource = Memory_Resource::default_resource())
+        : pages(page_mode), numa(numa_policy), node_mask(nodes), min_bytes(threshold), upstream(upstream_resource),
+          mapped(0), explicit_mapped(0) {}
+
+    Huge_Page_Resource(const Huge_Page_Resource&) = delete;
+    Huge_Page_Resource& operator=(const Huge_Page_Resource&) = delete;
+
+    void* allocate(size_type bytes, size_type alignment) override
+    {
+#if defined(__linux__)
+        if(bytes >= min_bytes && alignment <= 4096)
+        {
+            size_type length = round_up(bytes);
+            void* pointer = MAP_FAILED;
+
+            if(pages == Pages::explicit_huge)
+            {
+                pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if(pointer != MAP_FAILED)
+                    explicit_mapped.fetch_add(length, std::memory_order_relaxed);
+            }
+            if(pointer == MAP_FAILED)
+            {
+                pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if(pointer == MAP_FAILED)
+                    throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+                if(pages != Pages::normal)
+                    madvise(pointer, length, MADV_HUGEPAGE);
+#endif
+            }
+
+            apply_numa(pointer, length);
+            mapped.fetch_add(length, std::memory_order_relaxed);
+            return pointer;
+        }
+#endif
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void deallocate(void* pointer, size_type bytes, size_type alignment) override
+    {
+#if defined(__linux__)
+        if(bytes >= min_bytes && alignment <= 4096)
+        {
+            size_type length = round_up(bytes);
+            munmap(pointer, length);
+            mapped.fetch_sub(length, std::memory_order_relaxed);
+            return;
+        }
+#endif
+        upstream->deallocate(pointer, bytes, alignment);
+    }
+
+    // bytes currently mapped by this resource
+    size_type bytes_mapped() const
+    {
+        return mapped.load(std::memory_order_relaxed);
+    }
+
+    // bytes ever mapped with explicit huge pages; zero means every request fell back
+    size_type explicit_huge_bytes() const
+    {
+        return explicit_mapped.load(std::memory_order_relaxed);
+    }
+};
+
+// Counting Bloom filter whose probes for one key all fall into a single 64-byte block,
+// so a negative lookup touches one cache line. The bits of a block are checked together
+// (with AVX2/SSE4.1 when available); a byte-sized counter per bit lets keys be erased.
+class Blocked_Bloom_Filter
+{
+ public:
+    using size_type = std::size_t;
+    static constexpr size_type block_words = 8;
+    static constexpr size_type block_bits = block_words * 64;
+
+ private:
+    std::uint64_t* storage;
+    std::uint64_t* bits;
+    std::uint8_t* counters;
+    size_type blocks;
+    unsigned hash_count;
+    double rate;
+
+    // the tables' own hashes can be very weak (identity for integers), so remix them first
+    static constexpr std::uint64_t mix(std::uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    size_type block_of(std::uint64_t mixed) const
+    {
+        return static_cast<size_type>(((mixed >> 32) * blocks) >> 32);
+    }
+
+    // bit positions inside the block, derived from the low half by double hashing
+    static constexpr std::uint32_t bit_at(std::uint64_t mixed, unsigned i)
+    {
+        return (static_cast<std::uint32_t>(mixed) + i * (static_cast<std::uint32_t>(mixed >> 17) | 1)) % block_bits;
+    }
+
+    void make_mask(std::uint64_t mixed, std::uint64_t (&mask)[block_words]) const
+    {
+        for(size_type w = 0; w < block_words; ++w)
+            mask[w] = 0;
+
+        for(unsigned i = 0; i < hash_count; ++i)
+        {
+            std::uint32_t bit = bit_at(mixed, i);
+            mask[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+    }
+
+    void allocate()
+    {
+        // one extra block leaves room to align the bit array on a cache line
+        storage = new std::uint64_t[(blocks + 1) * block_words]();
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage);
+        bits = reinterpret_cast<std::uint64_t*>((address + 63) & ~std::uintptr_t(63));
+        counters = new std::uint8_t[blocks * block_bits]();
+    }
+
+    void release()
+    {
+        delete[] storage;
+        delete[] counters;
+        storage = bits = nullptr;
+        counters = nullptr;
+    }
+
+ public:
+    // the false positive rate is reached when at most expected_keys keys are stored
+    Blocked_Bloom_Filter(size_type expected_keys, double false_positive_rate = 0.01)
+        : storage(nullptr), bits(nullptr), counters(nullptr), blocks(1), hash_count(1), rate(false_positive_rate)
+    {
+        if(false_positive_rate <= 0.0 || false_positive_rate >= 1.0)
+            rate = false_positive_rate = 0.01;
+        if(expected_keys == 0)
+            expected_keys = 1;
+
+        // a blocked filter needs slightly more bits than a classic one for the same rate
+        const double ln2 = std::log(2.0);
+        double bits_per_key = 1.1 * -std::log(false_positive_rate) / (ln2 * ln2);
+        double optimal_hashes = std::round(bits_per_key * ln2);
+
+        hash_count = static_cast<unsigned>(std::min(std::max(optimal_hashes, 1.0), 16.0));
+        blocks = static_cast<size_type>(std::ceil(bits_per_key * expected_keys / block_bits));
+        if(blocks == 0)
+            blocks = 1;
+        allocate();
+    }
+
+    Blocked_Bloom_Filter(const Blocked_Bloom_Filter& other)
+        : storage(nullptr), bits(nullptr), counters(nullptr), blocks(other.blocks), hash_count(other.hash_count), rate(other.rate)
+    {
+        allocate();
+        std::memcpy(bits, other.bits, blocks * block_words * sizeof(std::uint64_t));
+        std::memcpy(counters, other.counters, blocks * block_bits);
+    }
+
+    Blocked_Bloom_Filter& operator=(const Blocked_Bloom_Filter& other)
+    {
+        if(this == &other)
+            return *this;
+
+        release();
+        blocks = other.blocks;
+        hash_count = other.hash_count;
+        rate = other.rate;
+        allocate();
+        std::memcpy(bits, other.bits, blocks * block_words * sizeof(std::uint64_t));
+        std::memcpy(counters, other.counters, blocks * block_bits);
+        return *this;
+    }
+
+    virtual ~Blocked_Bloom_Filter() { release(); }
+
+    void insert(size_type hash)
+    {
+        std::uint64_t mixed = mix(hash);
+        size_type block = block_of(mixed);
+        std::uint64_t* words = bits + block * block_words;
+        std::uint8_t* count = counters + block * block_bits;
+
+        for(unsigned i = 0; i < hash_count; ++i)
+        {
+            std::uint32_t bit = bit_at(mixed, i);
+            // a saturated counter sticks, its bit can no longer be cleared safely
+            if(count[bit] != 0xFF)
+                count[bit]++;
+            words[bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+    }
+
+    // must only be called for hashes that were inserted before
+    void erase(size_type hash)
+    {
+        std::uint64_t mixed = mix(hash);
+        size_type block = block_of(mixed);
+        std::uint64_t* words = bits + block * block_words;
+        std::uint8_t* count = counters + block * block_bits;
+
+        for(unsigned i = 0; i < hash_count; ++i)
+        {
+            std::uint32_t bit = bit_at(mixed, i);
+            if(count[bit] != 0xFF && count[bit] != 0 && --count[bit] == 0)
+                words[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+        }
+    }
+
+    bool may_contain(size_type hash) const
+    {
+        std::uint64_t mixed = mix(hash);
+        alignas(64) std::uint64_t mask[block_words];
+        make_mask(mixed, mask);
+
+        const std::uint64_t* words = bits + block_of(mixed) * block_words;
+#if defined(__AVX2__)
+        __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i*>(words));
+        __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i*>(words + 4));
+        return _mm256_testc_si256(low, _mm256_load_si256(reinterpret_cast<const __m256i*>(mask)))
+            && _mm256_testc_si256(high, _mm256_load_si256(reinterpret_cast<const __m256i*>(mask + 4)));
+#elif defined(__SSE4_1__)
+        for(size_type w = 0; w < block_words; w += 2)
+        {
+            __m128i word = _mm_load_si128(reinterpret_cast<const __m128i*>(words + w));
+            if(!_mm_testc_si128(word, _mm_load_si128(reinterpret_cast<const __m128i*>(mask + w))))
+                return false;
+        }
+        return true;
+#else
+        std::uint64_t missing = 0;
+        for(size_type w = 0; w < block_words; ++w)
+            missing |= mask[w] & ~words[w];
+        return missing == 0;
+#endif
+    }
+
+    void clear()
+    {
+        std::memset(bits, 0, blocks * block_words * sizeof(std::uint64_t));
+        std::memset(counters, 0, blocks * block_bits);
+    }
+
+    size_type block_count() const
+    {
+        return blocks;
+    }
+
+    unsigned hash_functions() const
+    {
+        return hash_count;
+    }
+
+    double false_positive_rate() const
+    {
+        return rate;
+    }
+
+    size_type memory_usage() const
+    {
+        return sizeof(*this) + (blocks + 1) * block_words * sizeof(std::uint64_t) + blocks * block_bits;
+    }
+};
+
+// Bulk set operations shared by the tables. One table is scanned in storage order while its keys
+// are looked up in the other in batches: the buckets of a whole batch are prefetched first, so
+// their cache misses overlap instead of being paid one lookup at a time. Scanning threads work
+// on disjoint slot ranges and only read both tables; all writes happen afterwards on one thread.
+template<typename Table>
+class Set_Operations
+{
+ public:
+    using value_type = typename Table::value_type;
+    using size_type = std::size_t;
+    using entry = std::pair<value_type, size_type>;
+    static constexpr size_type batch_size = 16;
+
+    static void prefetch(const void* address)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+        (void)address;
+#endif
+    }
+
+    // a hash stored by one table, converted for use in another one
+    static size_type hash_for(const Table& target, const Table& source, const value_type& key, size_type hash)
+    {
+        return (target.same_hasher(source)) ? hash : target.hash_of(key);
+    }
+
+    // keys of scan, with scan's hashes, whose presence in probe is wanted
+    static std::vector<entry> select(const Table& scan, const Table& probe, bool wanted, size_type threads)
+    {
+        std::vector<entry> result;
+        size_type slots = scan.slot_count();
+
+        if(threads <= 1 || slots < threads * batch_size)
+        {
+            select_range(scan, probe, wanted, 0, slots, result);
+            return result;
+        }
+
+        std::vector<std::vector<entry>> parts(threads);
+        std::vector<std::thread> workers;
+        size_type chunk = (slots + threads - 1) / threads;
+
+        for(size_type t = 0; t < threads && t * chunk < slots; ++t)
+        {
+            size_type first = t * chunk;
+            size_type last = std::min(slots, first + chunk);
+            workers.emplace_back(&Set_Operations::select_range, std::cref(scan), std::cref(probe), wanted, first, last, std::ref(parts[t]));
+        }
+        for(auto&& worker : workers)
+            worker.join();
+
+        for(auto&& part : parts)
+            result.insert(result.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        return result;
+    }
+
+    static void select_range(const Table& scan, const Table& probe, bool wanted, size_type first, size_type last, std::vector<entry>& result)
+    {
+        bool shared = scan.same_hasher(probe);
+        const value_type* keys[batch_size];
+        size_type scan_hashes[batch_size];
+        size_type probe_hashes[batch_size];
+        size_type filled = 0;
+
+        auto flush = [&]()
+        {
+            for(size_type i = 0; i < filled; ++i)
+                probe.prefetch_hashed(probe_hashes[i]);
+
+            for(size_type i = 0; i < filled; ++i)
+            {
+                if(probe.contains_hashed(*keys[i], probe_hashes[i]) == wanted)
+                    result.emplace_back(*keys[i], scan_hashes[i]);
+            }
+            filled = 0;
+        };
+
+        scan.for_each_hashed(first, last, [&](const value_type& key, size_type hash)
+        {
+            keys[filled] = &key;
+            scan_hashes[filled] = hash;
+            probe_hashes[filled] = (shared) ? hash : probe.hash_of(key);
+            if(++filled == batch_size)
+                flush();
+        });
+        flush();
+    }
+
+    static size_type merge(Table& target, const Table& source, size_type threads)
+    {
+        if(&target == &source)
+            return 0;
+
+        size_type inserted = 0;
+        for(auto&& missing : select(source, target, false, threads))
+        {
+            if(target.insert_hashed(missing.first, hash_for(target, source, missing.first, missing.second)))
+                inserted++;
+        }
+        return inserted;
+    }
+
+    static size_type intersect(Table& target, const Table& other, size_type threads)
+    {
+        if(&target == &other)
+            return 0;
+
+        size_type before = target.counter;
+        if(target.counter <= other.counter)
+        {
+            for(auto&& extra : select(target, other, false, threads))
+                target.erase_hashed(extra.first, extra.second);
+        }
+        else
+        {
+            // the other table is smaller: collect the common keys from it and rebuild with them
+            std::vector<entry> common = select(other, target, true, threads);
+            target.clear();
+            for(auto&& key : common)
+                target.insert_hashed(key.first, hash_for(target, other, key.first, key.second));
+        }
+        return before - target.counter;
+    }
+
+    static size_type difference(Table& target, const Table& other, size_type threads)
+    {
+        if(&target == &other)
+        {
+            size_type before = target.counter;
+            target.clear();
+            return before;
+        }
+
+        size_type removed = 0;
+        if(target.counter <= other.counter)
+        {
+            for(auto&& common : select(target, other, true, threads))
+                removed += target.erase_hashed(common.first, common.second);
+        }
+        else
+        {
+            for(auto&& common : select(other, target, true, threads))
+                removed += target.erase_hashed(common.first, hash_for(target, other, common.first, common.second));
+        }
+        return removed;
+    }
+
+    static Table union_of(const Table& first, const Table& second, size_type threads)
+    {
+        bool first_larger = (first.counter >= second.counter) ? true : false;
+        Table result(first_larger ? first : second);
+        merge(result, first_larger ? second : first, threads);
+        return result;
+    }
+};
+
+template<typename _Tp, std::size_t N> class Frozen_Hashtable;
+
+template<typename _Tp, std::size_t N = 100>
+class Hashtable_Chaining : public Hashing<_Tp, N>
+{
+ public:
+    using value_type = _Tp;
+    using reference = _Tp&;
+    using const_reference = const _Tp&;
+    using size_type = std::size_t;
+
+ private:
+    class DoublyLinkedList
+    {
+    public:
+        class Node
+        {
+        public:
+            using Node_pointer = Node*;
+            using Const_Node_ptr = const Node*;
+
+        private:
+            Node_pointer next;
+            Node_pointer prev;
+            value_type* key;
+            size_type hash;
+
+        public:
+            constexpr Node() : next(nullptr), prev(nullptr), key(nullptr), hash(0) {}
+
+            // the key is constructed by the list next to the node, in the same allocation (see make_node)
+            constexpr Node(value_type* _key, size_type _hash) : next(nullptr), prev(nullptr), key(_key), hash(_hash) {}
+
+            Node(const Node& other) = delete;
+            Node& operator=(const Node& other) = delete;
+
+            constexpr Node(Node&& other) noexcept : next(std::move(other.next)), prev(std::move(other.prev)), key(std::move(other.key)), hash(other.hash) {}
+
+            constexpr Node& operator=(Node&& other) noexcept
+            {
+                this->~Node();
+
+                next = other.next;
+                prev = other.prev;
+                key = other.key;
+                hash = other.hash;
+
+                other.next = nullptr;
+                other.prev = nullptr;
+                other.key = nullptr;
+                return (*this);
+            }
+
+            virtual ~Node()
+            {
+                clear();
+            }
+
+            constexpr reference getKey()
+            {
+                return *key;
+            }
+
+            constexpr const_reference getKey() const
+            {
+                return *key;
+            }
+
+            constexpr size_type getHash() const
+            {
+                return hash;
+            }
+
+            constexpr void setHash(size_type _hash)
+            {
+                hash = _hash;
+            }
+
+            // compare the stored hashes first, so that only keys with matching hashes are dereferenced
+            constexpr bool matches(const_reference _key, size_type _hash) const
+            {
+                return hash == _hash && *key == _key;
+            }
+
+            constexpr bool key_equals(const_reference _key) const
+            {
+                return *key == _key;
+            }
+
+            constexpr void setNext(const Node_pointer& newNext)
+            {
+                if(next && next->prev == this){
+                    next->prev = nullptr;
+                }
+                next = newNext;
+
+                if(newNext){
+                    if(newNext->prev){
+                        newNext->prev->next = nullptr;
+                    }
+                    newNext->prev = this;
+                }
+            }
+
+            constexpr Node_pointer getNext()
+            {
+                return next;
+            }
+
+            constexpr Const_Node_ptr getNext() const
+            {
+                return next;
+            }
+
+            constexpr void setPrevious(const Node_pointer& NewPrevious)
+            {
+                if(prev && prev->next == this){
+                    prev->next = nullptr;
+                }
+                prev = NewPrevious;
+
+                if(NewPrevious){
+                    if(NewPrevious->next){
+                        NewPrevious->next->prev = nullptr;
+                    }
+                    NewPrevious->next = this;
+                }
+            }
+
+            constexpr Node_pointer getPrevious()
+            {
+                return prev;
+            }
+
+            constexpr Const_Node_ptr getPrevious() const
+            {
+                return prev;
+            }
+
+            void clear()
+            {
+                key = nullptr;
+                if(next && next->prev == this){
+                    next->prev = nullptr;
+                }
+                if(prev && prev->next == this){
+                    prev->next = nullptr;
+                }
+                prev = next = nullptr;
+            }
+        };
+
+        using Node_ptr = typename Node::Node_pointer;
+        using ConstNPtr = typename Node::Const_Node_ptr;
+
+        // A node and its key share one allocation from the memory resource of the table, so that a
+        // Budget_Resource accounts for them; heap memory owned by the key itself is not covered.
+        static constexpr size_type key_offset = (sizeof(Node) + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+        static constexpr size_type node_bytes = key_offset + sizeof(value_type);
+        static constexpr size_type node_alignment = (alignof(Node) > alignof(value_type)) ? alignof(Node) : alignof(value_type);
+
+        template<typename Key>
+        static Node_ptr make_node(Memory_Resource* memory, Key&& key, size_type hash)
+        {
+            char* block = static_cast<char*>(memory->allocate(node_bytes, node_alignment));
+            value_type* stored;
+            try
+            {
+                stored = new (block + key_offset) value_type(std::forward<Key>(key));
+            }
+            catch(...)
+            {
+                memory->deallocate(block, node_bytes, node_alignment);
+                throw;
+            }
+            return new (block) Node(stored, hash);
+        }
+
+        static void destroy_node(Memory_Resource* memory, Node_ptr node)
+        {
+            node->getKey().~value_type();
+            node->~Node();
+            memory->deallocate(node, node_bytes, node_alignment);
+        }
+
+        // A bucket longer than treeify_threshold (by bad luck, or because someone chose keys that
+        // collide) also keeps its nodes in a vector sorted by hash, so a lookup in it is a binary
+        // search instead of a walk. The vector is dropped once the bucket shrinks back to
+        // untreeify_threshold; the gap keeps a bucket at the boundary from converting on every change.
+        static constexpr size_type treeify_threshold = 8;
+        static constexpr size_type untreeify_threshold = 6;
+
+    protected:
+        Node_ptr head;
+        Node_ptr tail;
+        size_type length;
+        std::vector<Node_ptr>* index;
+        // where the nodes of this bucket come from: the memory resource of the table
+        Memory_Resource* memory;
+
+        static bool hash_less(ConstNPtr node, size_type hash)
+        {
+            return node->getHash() < hash;
+        }
+
+        void treeify()
+        {
+            index = new std::vector<Node_ptr>();
+            index->reserve(length);
+            for(Node_ptr current = head; current; current = current->getNext()){
+                index->push_back(current);
+            }
+            std::sort(index->begin(), index->end(), [](ConstNPtr first, ConstNPtr second){
+                return first->getHash() < second->getHash();
+            });
+        }
+
+        void untreeify()
+        {
+            delete index;
+            index = nullptr;
+        }
+
+        // append copies of the nodes of other, which must be empty here
+        void copy_nodes(const DoublyLinkedList& other)
+        {
+            try
+            {
+                for(ConstNPtr current = other.head; current; current = current->getNext())
+                {
+                    Node_ptr node = make_node(memory, current->getKey(), current->getHash());
+                    if(tail){
+                        tail->setNext(node);
+                    }
+                    else{
+                        head = node;
+                    }
+                    tail = node;
+                    length++;
+                }
+            }
+            catch(...)
+            {
+                clear();
+                throw;
+            }
+            if(other.index){
+                treeify();
+            }
+        }
+
+        // called once node has been linked and counted
+        void index_node(Node_ptr node)
+        {
+            if(index){
+                index->insert(std::lower_bound(index->begin(), index->end(), node->getHash(), hash_less), node);
+            }
+            else if(length > treeify_threshold){
+                treeify();
+            }
+        }
+
+        // called while node is still linked and counted
+        void unindex(Node_ptr node)
+        {
+            if(!index){
+                return;
+            }
+            if(length - 1 <= untreeify_threshold){
+                untreeify();
+                return;
+            }
+
+            auto it = std::lower_bound(index->begin(), index->end(), node->getHash(), hash_less);
+            while(*it != node){
+                ++it;
+            }
+            index->erase(it);
+        }
+
+    public:
+        constexpr DoublyLinkedList() : DoublyLinkedList(Memory_Resource::default_resource()) {}
+
+        explicit constexpr DoublyLinkedList(Memory_Resource* resource) : head(nullptr), tail(nullptr), length(0), index(nullptr), memory(resource) {}
+
+        constexpr DoublyLinkedList(std::initializer_list<value_type> initList) : DoublyLinkedList()
+        {
+            for(auto&& i : initList) {
+                insert(i);
+            }
+        }
+
+        // a copy takes its nodes from the same resource as other, as a table copy shares the resource
+        constexpr DoublyLinkedList(const DoublyLinkedList& other) : DoublyLinkedList(other.memory)
+        {
+            copy_nodes(other);
+        }
+
+        constexpr DoublyLinkedList(DoublyLinkedList&& other) noexcept
+            : head(other.head), tail(other.tail), length(other.length), index(other.index), memory(other.memory)
+        {
+            other.head = other.tail = nullptr;
+            other.length = 0;
+            other.index = nullptr;
+        }
+
+        constexpr DoublyLinkedList& operator=(const DoublyLinkedList& other)
+        {
+            if(this == &other) {
+                    return (*this);
+            }
+
+            clear();
+            copy_nodes(other);
+            return (*this);
+        }
+
+        constexpr DoublyLinkedList& operator=(DoublyLinkedList&& other) noexcept
+        {
+            if(this == &other) {
+                    return (*this);
+            }
+
+            clear();
+            head = other.head;
+            tail = other.tail;
+            length = other.length;
+            index = other.index;
+            // the nodes go back to the resource they came from
+            memory = other.memory;
+            other.head = nullptr;
+            other.tail = nullptr;
+            other.length = 0;
+            other.index = nullptr;
+            return (*this);
+        }
+
+        virtual ~DoublyLinkedList()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            if(length)
+            {
+                Node_ptr current = head;
+                while(current)
+                {
+                    Node_ptr delTmp = current;
+                    current = current->getNext();
+                    destroy_node(memory, delTmp);
+                }
+                head = tail = nullptr; length = 0;
+            }
+            untreeify();
+        }
+
+        constexpr void push_front(const_reference value, size_type hash)
+        {
+            Node_ptr node = make_node(memory, value, hash);
+            if(!length){
+                head = node;
+                length++;
+                tail = head;
+            } else {
+                head->setPrevious(node);
+                length++;
+                head = node;
+            }
+            index_node(head);
+        }
+
+        constexpr void push_back(const_reference value, size_type hash)
+        {
+            Node_ptr node = make_node(memory, value, hash);
+            if(!length){
+                head = node;
+                length++;
+                tail = head;
+            }
+            else {
+                tail->setNext(node);
+                length++;
+                tail = node;
+            }
+            index_node(tail);
+        }
+
+        constexpr void pop_front()
+        {
+            if(!length){
+                return;
+            }
+            unindex(head);
+
+            if(length == 1){
+                destroy_node(memory, head);
+                length--;
+                head = tail = nullptr;
+            }
+            else{
+                Node_ptr tmp = head;
+                head = head->getNext();
+                destroy_node(memory, tmp);
+                length--;
+            }
+        }
+
+        constexpr void pop_back()
+        {
+            if(!length){
+                return;
+            }
+            unindex(tail);
+
+            if(length == 1){
+                destroy_node(memory, head);
+                length--;
+                head = tail = nullptr;
+            }
+            else{
+                Node_ptr tmp = tail;
+                tail = tail->getPrevious();
+                destroy_node(memory, tmp);
+                length--;
+            }
+        }
+
+        constexpr Node_ptr search(const_reference value, size_type hash) const
+        {
+            if(index){
+                auto it = std::lower_bound(index->begin(), index->end(), hash, hash_less);
+                for(; it != index->end() && (*it)->getHash() == hash; ++it){
+                    if((*it)->key_equals(value)){
+                        return *it;
+                    }
+                }
+                return nullptr;
+            }
+
+            Node_ptr current = head;
+            while(current)
+            {
+                if(current->matches(value, hash)){
+                    return current;
+                }
+                current = current->getNext();
+            }
+            return nullptr;
+        }
+
+        // detach node from the list without destroying it
+        constexpr Node_ptr unlink(Node_ptr node)
+        {
+            unindex(node);
+            Node_ptr tmp_prev = node->getPrevious();
+            Node_ptr tmp_next = node->getNext();
+            node->setNext(nullptr);
+            node->setPrevious(nullptr);
+
+            if(tmp_prev){
+                tmp_prev->setNext(tmp_next);
+            }
+            else{
+                head = tmp_next;
+            }
+            if(!tmp_next){
+                tail = tmp_prev;
+            }
+            length--;
+            return node;
+        }
+
+        // unlink node from the list and destroy it
+        constexpr void remove(Node_ptr node)
+        {
+            destroy_node(memory, unlink(node));
+        }
+
+        constexpr size_type erase(const_reference value, size_type hash)
+        {
+            size_type count = 0;
+            if(index){
+                while(Node_ptr node = search(value, hash)){
+                    remove(node);
+                    count++;
+                }
+                return count;
+            }
+
+            Node_ptr current = head;
+            while(current)
+            {
+                if(current->matches(value, hash))
+                {
+                    Node_ptr temp = current;
+                    current = current->getNext();
+                    remove(temp);
+                    count++;
+                }
+                else{
+                    current = current->getNext();
+                }
+            }
+            return count;
+        }
+
+        constexpr void display(std::ostream& out) const
+        {
+            if(empty())
+                return;
+
+            Node_ptr current = head;
+            while(current->getNext()){
+                out << current->getKey() << " -> ";
+                current = current->getNext();
+            }
+            out << current->getKey();
+            out << '\n';
+        }
+
+        constexpr void display() const
+        {
+            display(std::cout);
+        }
+
+        constexpr bool empty() const
+        {
+            return (!length) ? true : false;
+        }
+
+        constexpr size_type size() const
+        {
+            return length;
+        }
+
+        constexpr Node_ptr getHead() const
+        {
+            return head;
+        }
+
+        constexpr bool treeified() const
+        {
+            return (index != nullptr) ? true : false;
+        }
+
+        // heap bytes of the sorted index, when there is one
+        size_type index_memory() const
+        {
+            return (index) ? sizeof(*index) + index->capacity() * sizeof(Node_ptr) : 0;
+        }
+
+        // detach the first node without destroying it
+        constexpr Node_ptr unlink_front()
+        {
+            Node_ptr node = head;
+            if(!node){
+                return nullptr;
+            }
+            unindex(node);
+
+            head = node->getNext();
+            node->setNext(nullptr);
+            if(!head){
+                tail = nullptr;
+            }
+            length--;
+            return node;
+        }
+
+        // append a detached node, taking ownership of it
+        constexpr void link_back(Node_ptr node)
+        {
+            if(!length){
+                head = tail = node;
+            }
+            else{
+                tail->setNext(node);
+                tail = node;
+            }
+            length++;
+            index_node(node);
+        }
+    };
+
+ public:
+    using DLL_ptr = DoublyLinkedList*;
+    using Node_ptr = typename DoublyLinkedList::Node_ptr;
+    using Const_Node_ptr = typename DoublyLinkedList::ConstNPtr;
+
+    // Owns a node taken out of a table by extract(), so that its key can be inserted into another
+    // table without being freed and allocated again. A handle is empty when extract() found
+    // nothing or once its node has been inserted; an unused node is destroyed with the handle.
+    class Node_Handle
+    {
+     public:
+        Node_Handle() : node(nullptr), seed(0), memory(nullptr) {}
+
+        Node_Handle(Node_Handle&& other) noexcept : node(other.node), seed(other.seed), memory(other.memory)
+        {
+            other.node = nullptr;
+        }
+
+        Node_Handle& operator=(Node_Handle&& other) noexcept
+        {
+            if(this != &other){
+                reset();
+                node = other.node;
+                seed = other.seed;
+                memory = other.memory;
+                other.node = nullptr;
+            }
+            return (*this);
+        }
+
+        ~Node_Handle()
+        {
+            reset();
+        }
+
+        bool empty() const
+        {
+            return (node == nullptr) ? true : false;
+        }
+
+        explicit operator bool() const
+        {
+            return !empty();
+        }
+
+        // the key stays read-only so that the hash stored with it remains valid
+        const_reference value() const
+        {
+            return node->getKey();
+        }
+
+     private:
+        friend class Hashtable_Chaining;
+
+        Node_ptr node;
+        // the seed the stored hash was computed with
+        size_type seed;
+        // the resource the node was allocated from
+        Memory_Resource* memory;
+
+        Node_Handle(Node_ptr _node, size_type _seed, Memory_Resource* _memory) : node(_node), seed(_seed), memory(_memory) {}
+
+        void reset()
+        {
+            if(node){
+                DoublyLinkedList::destroy_node(memory, node);
+                node = nullptr;
+            }
+        }
+    };
+
+ protected:
+    Cow_Array<DoublyLinkedList> arr;
+    size_type counter;
+    Blocked_Bloom_Filter* filter;
+    size_type table_size;
+    Memory_Resource* resource;
+    // keys are hashed with a random per-table seed, so that clients cannot pick keys that share a
+    // bucket; copies keep the seed together with the stored hashes
+    size_type seed;
+
+ private:
+    constexpr size_type index_of(size_type hash) const
+    {
+        return hash % table_size;
+    }
+
+    // move every node into a new array of buckets, placed by its stored hash; nothing is rehashed or copied
+    void rebuild(size_type new_size)
+    {
+        Cow_Array<DoublyLinkedList> new_arr(resource, new_size, resource);
+
+        for(size_type i = 0; i < table_size; ++i)
+        {
+            if(arr[i].empty()){
+                continue;
+            }
+
+            DoublyLinkedList& bucket = arr.write(i);
+            while(Node_ptr node = bucket.unlink_front()){
+                new_arr.write(node->getHash() % new_size).link_back(node);
+            }
+        }
+
+        arr = std::move(new_arr);
+        table_size = new_size;
+
+        if(filter){
+            enable_filter(filter->false_positive_rate());
+        }
+    }
+
+ public:
+    Hashtable_Chaining() : Hashtable_Chaining(Memory_Resource::default_resource()) {}
+
+    explicit Hashtable_Chaining(Memory_Resource* memory) : Hashtable_Chaining(memory, this->Random_Seed()) {}
+
+    // Tables built with the same seed hash alike, so stored hashes carry over between them: set
+    // operations, node handles and merge then never rehash a key. Give a group of shards one seed
+    // (e.g. the hash_seed() of the first), and keep it away from clients.
+    Hashtable_Chaining(Memory_Resource* memory, size_type hash_seed)
+        : arr(memory, N, memory), counter(0), filter(nullptr), table_size(N), resource(memory), seed(hash_seed) {}
+
+    Hashtable_Chaining(std::initializer_list<value_type> initList, Memory_Resource* memory = Memory_Resource::default_resource())
+        : Hashtable_Chaining(memory)
+    {
+        for(auto&& value : initList){
+            insert(value);
+        }
+    }
+
+    // A copy is an O(1) snapshot: it shares the buckets with other, and either table copies a
+    // segment of buckets only when it first modifies it. The snapshot can be read (and destroyed)
+    // on another thread while the original keeps changing, provided the memory resource is
+    // thread-safe, as all resources in this header are. An attached filter is copied eagerly.
+    Hashtable_Chaining(const Hashtable_Chaining& other)
+        : arr(other.arr), counter(other.counter), filter(nullptr), table_size(other.table_size), resource(other.resource), seed(other.seed)
+    {
+        if(other.filter){
+            filter = new Blocked_Bloom_Filter(*other.filter);
+        }
+    }
+
+    Hashtable_Chaining(Hashtable_Chaining&& other) noexcept
+        : arr(std::move(other.arr)), counter(other.counter), filter(other.filter), table_size(other.table_size), resource(other.resource),
+          seed(other.seed)
+    {
+        other.counter = 0;
+        other.filter = nullptr;
+    }
+
+    // shares other's buckets like the copy constructor when both tables use the same memory
+    // resource, and copies them into this table's resource otherwise
+    Hashtable_Chaining& operator=(const Hashtable_Chaining& other)
+    {
+        if(this == &other) { return (*this); }
+
+        if(other.resource == resource){
+            arr = other.arr;
+        }
+        else{
+            // the buckets carry the resource their nodes come from, so they are rebuilt rather than copied
+            Cow_Array<DoublyLinkedList> copy(resource, other.table_size, resource);
+            for(size_type i = 0; i < other.table_size; ++i)
+            {
+                for(Node_ptr current = other.arr[i].getHead(); current; current = current->getNext()){
+                    copy.write(i).push_back(current->getKey(), current->getHash());
+                }
+            }
+            arr = std::move(copy);
+        }
+        counter = other.counter;
+        table_size = other.table_size;
+        seed = other.seed;
+
+        delete filter;
+        filter = (other.filter) ? new Blocked_Bloom_Filter(*other.filter) : nullptr;
+
+        return (*this);
+    }
+
+    Hashtable_Chaining& operator=(Hashtable_Chaining&& other) noexcept
+    {
+        if(this == &other) { return (*this); }
+
+        disable_filter();
+        arr = std::move(other.arr);
+        counter = other.counter;
+        filter = other.filter;
+        table_size = other.table_size;
+        resource = other.resource;
+        seed = other.seed;
+        other.counter = 0;
+        other.filter = nullptr;
+        return (*this);
+    }
+
+    virtual ~Hashtable_Chaining()
+    {
+        counter = 0;
+        disable_filter();
+    }
+
+    // Put a counting Bloom filter in front of the buckets, so that most searches for absent
+    // keys are answered from one cache line. The filter is kept up to date by insert and erase.
+    void enable_filter(double false_positive_rate = 0.01, size_type expected_keys = 0)
+    {
+        disable_filter();
+        filter = new Blocked_Bloom_Filter(std::max(std::max(expected_keys, counter), table_size), false_positive_rate);
+
+        for(size_type i = 0; i < table_size; ++i)
+        {
+            for(Node_ptr current = arr[i].getHead(); current; current = current->getNext()){
+                filter->insert(current->getHash());
+            }
+        }
+    }
+
+    void disable_filter()
+    {
+        if(filter){
+            delete filter;
+            filter = nullptr;
+        }
+    }
+
+    constexpr bool has_filter() const
+    {
+        return (filter != nullptr) ? true : false;
+    }
+
+    constexpr size_type bucket_count() const
+    {
+        return table_size;
+    }
+
+    constexpr size_type hash_seed() const
+    {
+        return seed;
+    }
+
+    // make room for n keys at one key per bucket
+    void reserve(size_type n)
+    {
+        if(n > table_size){
+            rebuild(n);
+        }
+    }
+
+    // give back the buckets that the current keys do not need
+    void shrink_to_fit()
+    {
+        size_type needed = std::max(counter, size_type(1));
+        if(needed < table_size){
+            rebuild(needed);
+        }
+    }
+
+    // bytes held by the table: bucket array, nodes, keys with their heap buffers, sorted indexes of
+    // long buckets, and the filter
+    size_type memory_usage() const
+    {
+        size_type bytes = sizeof(*this) + arr.memory_usage() + counter * DoublyLinkedList::node_bytes;
+        for(size_type i = 0; i < table_size; ++i)
+        {
+            bytes += arr[i].index_memory();
+            for(Node_ptr current = arr[i].getHead(); current; current = current->getNext()){
+                bytes += this->External_Bytes(current->getKey());
+            }
+        }
+        return (filter) ? bytes + filter->memory_usage() : bytes;
+    }
+
+    // Build an immutable snapshot in a compact layout (see Frozen_Hashtable) for read-only phases.
+    // The stored hashes are reused, so no key is hashed again.
+    Frozen_Hashtable<_Tp, N> freeze() const
+    {
+        Frozen_Hashtable<_Tp, N> frozen;
+        frozen.seed = seed;
+        size_type buckets = std::max(counter, size_type(1));
+
+        // counting sort by bucket: sizes first, then prefix sums, then placement
+        std::vector<size_type> offsets(buckets + 1, 0);
+        for_each_hashed(0, table_size, [&](const_reference, size_type hash){
+            offsets[hash % buckets + 1]++;
+        });
+        for(size_type i = 0; i < buckets; ++i){
+            offsets[i + 1] += offsets[i];
+        }
+
+        std::vector<size_type> cursor(offsets.begin(), offsets.end() - 1);
+        std::vector<const value_type*> order(counter);
+        frozen.fingerprints.resize(counter);
+        for_each_hashed(0, table_size, [&](const_reference key, size_type hash){
+            size_type position = cursor[hash % buckets]++;
+            order[position] = &key;
+            frozen.fingerprints[position] = Frozen_Hashtable<_Tp, N>::fingerprint_of(hash);
+        });
+
+        frozen.keys.reserve(counter);
+        for(auto&& key : order){
+            frozen.keys.push_back(*key);
+        }
+        frozen.offsets.swap(offsets);
+        return frozen;
+    }
+
+    constexpr size_type size()
+    {
+        return counter;
+    }
+
+    constexpr bool empty()
+    {
+        return (!counter) ? true : false;
+    }
+
+ private:
+    friend class Set_Operations<Hashtable_Chaining>;
+
+    size_type hash_of(const_reference value) const
+    {
+        return this->Seeded_Hash(value, seed);
+    }
+
+    // stored hashes can only be shared between tables with the same seed, i.e. copies of each other
+    constexpr bool same_hasher(const Hashtable_Chaining& other) const
+    {
+        return (seed == other.seed) ? true : false;
+    }
+
+    constexpr size_type slot_count() const
+    {
+        return table_size;
+    }
+
+    // calls f(key, stored hash) for every key in the buckets [first, last)
+    template<typename Function>
+    void for_each_hashed(size_type first, size_type last, Function f) const
+    {
+        for(size_type i = first; i < last; ++i)
+        {
+            for(Node_ptr current = arr[i].getHead(); current; current = current->getNext()){
+                f(current->getKey(), current->getHash());
+            }
+        }
+    }
+
+    void prefetch_hashed(size_type hash) const
+    {
+        Set_Operations<Hashtable_Chaining>::prefetch(&arr[index_of(hash)]);
+    }
+
+    constexpr bool insert_hashed(const_reference value, size_type hash)
+    {
+        size_type index = index_of(hash);
+        if(!arr[index].search(value, hash))
+        {
+            arr.write(index).push_back(value, hash);
+            counter++;
+            if(filter){
+                filter->insert(hash);
+            }
+            return true;
+        }
+        else{
+            return false;
+        }
+    }
+
+    constexpr bool contains_hashed(const_reference value, size_type hash) const
+    {
+        if(filter && !filter->may_contain(hash)){
+            return false;
+        }
+
+        size_type index = index_of(hash);
+        return (arr[index].search(value, hash) != nullptr) ? true : false;
+    }
+
+    // link a detached node into its bucket, storing hash with it
+    void adopt(Node_ptr node, size_type hash)
+    {
+        node->setHash(hash);
+        arr.write(index_of(hash)).link_back(node);
+        counter++;
+        if(filter){
+            filter->insert(hash);
+        }
+    }
+
+    // node itself when it was allocated from this table's resource, and otherwise a new node of this
+    // resource holding its key, moved; the caller then destroys node
+    Node_ptr own_node(Node_ptr node, Memory_Resource* from)
+    {
+        if(from == resource){
+            return node;
+        }
+        return DoublyLinkedList::make_node(resource, std::move(node->getKey()), node->getHash());
+    }
+
+    // detach node from the bucket index, which must already be writable
+    Node_ptr release(size_type index, Node_ptr node)
+    {
+        arr.write(index).unlink(node);
+        counter--;
+        if(filter){
+            filter->erase(node->getHash());
+        }
+        return node;
+    }
+
+    constexpr size_type erase_hashed(const_reference value, size_type hash)
+    {
+        size_type index = index_of(hash);
+        // only a bucket that holds the value is written, so a miss never copies a shared segment
+        if(!arr[index].search(value, hash)){
+            return 0;
+        }
+
+        size_type erase_count = arr.write(index).erase(value, hash);
+        counter -= erase_count;
+        for(size_type i = 0; filter && i < erase_count; ++i){
+            filter->erase(hash);
+        }
+        return erase_count;
+    }
+
+ public:
+    constexpr bool insert(const_reference value)
+    {
+        return insert_hashed(value, hash_of(value));
+    }
+
+    constexpr bool search(const_reference value)
+    {
+        return contains_hashed(value, hash_of(value));
+    }
+
+    constexpr size_type erase(const_reference value)
+    {
+        return erase_hashed(value, hash_of(value));
+    }
+
+    // Take the node holding value out of the table, or return an empty handle when there is none.
+    // No key is copied; a bucket still shared with a snapshot is copied first, as for erase.
+    Node_Handle extract(const_reference value)
+    {
+        size_type hash = hash_of(value);
+        size_type index = index_of(hash);
+        if(!arr[index].search(value, hash)){
+            return Node_Handle();
+        }
+
+        return Node_Handle(release(index, arr.write(index).search(value, hash)), seed, resource);
+    }
+
+    // Link the node of handle into this table, reusing its stored hash when it comes from a table
+    // with the same seed. Returns false and leaves the node in handle when the key is already here.
+    // A node from a table with another memory resource has its key moved into a node of this one.
+    bool insert(Node_Handle&& handle)
+    {
+        if(handle.empty()){
+            return false;
+        }
+
+        Node_ptr node = handle.node;
+        size_type hash = (handle.seed == seed) ? node->getHash() : hash_of(node->getKey());
+        node->setHash(hash);
+        handle.seed = seed;
+        if(arr[index_of(hash)].search(node->getKey(), hash)){
+            return false;
+        }
+
+        Node_ptr own = own_node(node, handle.memory);
+        if(own != node){
+            DoublyLinkedList::destroy_node(handle.memory, node);
+        }
+        adopt(own, hash);
+        handle.node = nullptr;
+        return true;
+    }
+
+    // Move every node of other whose key is missing here into this table by relinking it, without
+    // allocating or copying keys when both tables use the same memory resource (otherwise each key
+    // is moved into a node of this table's resource); nodes with keys already present stay in
+    // other. The set algebra merge(const Hashtable_Chaining&) below copies instead and leaves
+    // other alone. Returns how many nodes moved.
+    size_type splice_from(Hashtable_Chaining& other)
+    {
+        if(this == &other){
+            return 0;
+        }
+
+        size_type moved = 0;
+        bool shared = same_hasher(other);
+        auto hash_in_this = [&](Const_Node_ptr node) -> size_type
+        {
+            return (shared) ? node->getHash() : hash_of(node->getKey());
+        };
+        auto present = [&](Const_Node_ptr node, size_type hash) -> bool
+        {
+            return (arr[index_of(hash)].search(node->getKey(), hash) != nullptr) ? true : false;
+        };
+
+        for(size_type i = 0; i < other.table_size; ++i)
+        {
+            // read the bucket first: write() copies a bucket still shared with a snapshot, so it is
+            // only called once some node is known to leave
+            Const_Node_ptr node = other.arr[i].getHead();
+            size_type staying = 0;
+            size_type hash = 0;
+            while(node){
+                hash = hash_in_this(node);
+                if(!present(node, hash)){
+                    break;
+                }
+                node = node->getNext();
+                staying++;
+            }
+            if(!node){
+                continue;
+            }
+
+            // resume at the first leaving node, whose hash is already known, so no key is hashed twice
+            Node_ptr current = other.arr.write(i).getHead();
+            for(; staying > 0; --staying){
+                current = current->getNext();
+            }
+            while(current)
+            {
+                Node_ptr next = current->getNext();
+                if(!present(current, hash)){
+                    Node_ptr own = own_node(current, other.resource);
+                    other.release(i, current);
+                    if(own != current){
+                        DoublyLinkedList::destroy_node(other.resource, current);
+                    }
+                    adopt(own, hash);
+                    moved++;
+                }
+                current = next;
+                if(current){
+                    hash = hash_in_this(current);
+                }
+            }
+        }
+        return moved;
+    }
+
+    // Look up values[0, n) and store each answer in found, returning how many were found.
+    // Up to group lookups are interleaved as small state machines (AMAC): before each step that
+    // dereferences a bucket, node or key, the lookup prefetches the address and yields to the
+    // next one, so a single thread keeps several cache misses in flight.
+    size_type search_batch(const value_type* values, size_type n, bool* found, size_type group = 16) const
+    {
+        enum class stage { bucket, node, key };
+        struct lookup
+        {
+            size_type position;
+            size_type hash;
+            stage next;
+            Node_ptr node;
+        };
+
+        constexpr size_type max_group = 32;
+        lookup slots[max_group];
+        group = std::min(std::max(group, size_type(1)), max_group);
+
+        size_type started = 0;
+        size_type active = 0;
+        size_type hits = 0;
+
+        // begin the next lookup that is not answered by the filter alone
+        auto start = [&](lookup& slot) -> bool
+        {
+            while(started < n)
+            {
+                size_type position = started++;
+                size_type hash = hash_of(values[position]);
+                if(filter && !filter->may_contain(hash)){
+                    found[position] = false;
+                    continue;
+                }
+
+                slot.position = position;
+                slot.hash = hash;
+                slot.next = stage::bucket;
+                slot.node = nullptr;
+                Set_Operations<Hashtable_Chaining>::prefetch(&arr[index_of(hash)]);
+                return true;
+            }
+            return false;
+        };
+
+        auto finish = [&](lookup& slot, bool result) -> bool
+        {
+            found[slot.position] = result;
+            hits += (result) ? 1 : 0;
+            return start(slot);
+        };
+
+        while(active < group && start(slots[active])){
+            active++;
+        }
+
+        size_type i = 0;
+        while(active)
+        {
+            lookup& slot = slots[i];
+            bool running = true;
+
+            switch(slot.next)
+            {
+            case stage::bucket:
+                // a treeified bucket is searched in one step, its binary search beats walking the chain
+                if(arr[index_of(slot.hash)].treeified()){
+                    running = finish(slot, arr[index_of(slot.hash)].search(values[slot.position], slot.hash) != nullptr);
+                    break;
+                }
+                slot.node = arr[index_of(slot.hash)].getHead();
+                if(!slot.node){
+                    running = finish(slot, false);
+                    break;
+                }
+                Set_Operations<Hashtable_Chaining>::prefetch(slot.node);
+                slot.next = stage::node;
+                break;
+
+            case stage::node:
+                if(slot.node->getHash() == slot.hash){
+                    Set_Operations<Hashtable_Chaining>::prefetch(&slot.node->getKey());
+                    slot.next = stage::key;
+                    break;
+                }
+                slot.node = slot.node->getNext();
+                if(!slot.node){
+                    running = finish(slot, false);
+                    break;
+                }
+                Set_Operations<Hashtable_Chaining>::prefetch(slot.node);
+                break;
+
+            case stage::key:
+                if(slot.node->getKey() == values[slot.position]){
+                    running = finish(slot, true);
+                    break;
+                }
+                slot.node = slot.node->getNext();
+                if(!slot.node){
+                    running = finish(slot, false);
+                    break;
+                }
+                Set_Operations<Hashtable_Chaining>::prefetch(slot.node);
+                slot.next = stage::node;
+                break;
+            }
+
+            // no key left to start: retire this slot by moving the last active one into it
+            if(!running){
+                slots[i] = slots[--active];
+            }
+            else{
+                i++;
+            }
+            if(i >= active){
+                i = 0;
+            }
+        }
+        return hits;
+    }
+
+    // Set algebra with another table: the smaller table is scanned, its keys are looked up in the
+    // other one in prefetched batches, and threads > 1 splits the scan over disjoint bucket ranges.
+    // merge, intersect_with and difference return how many keys were inserted or removed.
+    size_type merge(const Hashtable_Chaining& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Chaining>::merge(*this, other, threads);
+    }
+
+    size_type intersect_with(const Hashtable_Chaining& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Chaining>::intersect(*this, other, threads);
+    }
+
+    size_type difference(const Hashtable_Chaining& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Chaining>::difference(*this, other, threads);
+    }
+
+    static Hashtable_Chaining union_of(const Hashtable_Chaining& first, const Hashtable_Chaining& second, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Chaining>::union_of(first, second, threads);
+    }
+
+    // Empties the buckets in place; buckets still shared with a snapshot are let go before new
+    // ones are allocated, so clearing never holds two bucket arrays at once.
+    void clear() override
+    {
+        if(counter){
+            counter = 0;
+            if(!arr.shared()){
+                for(size_type i = 0; i < table_size; ++i){
+                    if(!arr[i].empty()){
+                        arr.write(i).clear();
+                    }
+                }
+            }
+            else{
+                arr = Cow_Array<DoublyLinkedList>();
+                arr = Cow_Array<DoublyLinkedList>(resource, table_size, resource);
+            }
+        }
+        if(filter){
+            filter->clear();
+        }
+    }
+
+    constexpr void display(std::ostream& out) const
+    {
+        for(size_type i = 0; i < table_size; ++i)
+        {
+            if(!arr[i].empty())
+            {
+                out << "List #" << i + 1 << ": ";
+                arr[i].display(out);
+            }
+        }
+    }
+
+    constexpr void display() const
+    {
+        display(std::cout);
+    }
+};
+
+// Immutable, read-optimized copy of a Hashtable_Chaining produced by Hashtable_Chaining::freeze().
+// All keys sit in one array grouped by bucket (CSR layout): bucket i holds the keys
+// [offsets[i], offsets[i + 1]), each with a one-byte fingerprint of its hash. A lookup is one
+// offset read and a short contiguous scan that only compares keys with a matching fingerprint.
+template<typename _Tp, std::size_t N = 100>
+class Frozen_Hashtable : public Hashing<_Tp, N>
+{
+ public:
+    using value_type = _Tp;
+    using reference = _Tp&;
+    using const_reference = const _Tp&;
+    using size_type = std::size_t;
+
+ private:
+    friend class Hashtable_Chaining<_Tp, N>;
+
+    std::vector<value_type> keys;
+    std::vector<std::uint8_t> fingerprints;
+    std::vector<size_type> offsets;
+    // the seed of the table it was frozen from
+    size_type seed;
+
+    static std::uint8_t fingerprint_of(size_type hash)
+    {
+        return static_cast<std::uint8_t>((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 56);
+    }
+
+    size_type index_of(size_type hash) const
+    {
+        return hash % bucket_count();
+    }
+
+ public:
+    Frozen_Hashtable() : keys(), fingerprints(), offsets(2, 0), seed(0) {}
+
+    bool search(const_reference value) const
+    {
+        size_type hash = this->Seeded_Hash(value, seed);
+        size_type index = index_of(hash);
+        std::uint8_t fingerprint = fingerprint_of(hash);
+
+        for(size_type i = offsets[index]; i < offsets[index + 1]; ++i)
+        {
+            if(fingerprints[i] == fingerprint && keys[i] == value)
+                return true;
+        }
+        return false;
+    }
+
+    size_type size() const
+    {
+        return keys.size();
+    }
+
+    bool empty() const
+    {
+        return keys.empty();
+    }
+
+    size_type bucket_count() const
+    {
+        return offsets.size() - 1;
+    }
+
+    // releases every key; a frozen table cannot be refilled, freeze a table again instead
+    void clear() override
+    {
+        std::vector<value_type>().swap(keys);
+        std::vector<std::uint8_t>().swap(fingerprints);
+        std::vector<size_type>(2, 0).swap(offsets);
+    }
+
+    size_type memory_usage() const
+    {
+        size_type bytes = sizeof(*this) + keys.capacity() * sizeof(value_type) + fingerprints.capacity()
+                        + offsets.capacity() * sizeof(size_type);
+        for(auto&& key : keys)
+            bytes += this->External_Bytes(key);
+        return bytes;
+    }
+
+    void display(std::ostream& out) const
+    {
+        for(size_type i = 0; i < bucket_count(); ++i)
+        {
+            if(offsets[i] == offsets[i + 1])
+                continue;
+
+            out << "List #" << i + 1 << ": ";
+            for(size_type k = offsets[i]; k < offsets[i + 1]; ++k)
+                out << keys[k] << ((k + 1 < offsets[i + 1]) ? " -> " : "\n");
+        }
+    }
+
+    void display() const
+    {
+        display(std::cout);
+    }
+};
+
+// Probe sequences for Hashtable_Probing, chosen with its Probe template parameter. A policy
+// gives the number of slots to use for a requested size, the stride of a hash, and the slot
+// that follows index on the attempt-th step (1, 2, ...). Each sequence visits every slot
+// within size steps, so insert, search and erase can stop after table_size probes. The home
+// slot comes from the mixed hash, masked instead of reduced when power_of_two is set.
+
+// the next slot each time: the best locality, but runs of full slots merge (primary clustering)
+struct Linear_Probing
+{
+    using size_type = std::size_t;
+
+    static constexpr bool power_of_two = false;
+
+    static constexpr size_type capacity(size_type n)
+    {
+        return n;
+    }
+
+    static constexpr size_type stride(size_type, size_type)
+    {
+        return 1;
+    }
+
+    static constexpr size_type next(size_type index, size_type, size_type, size_type size)
+    {
+        return (index + 1) % size;
+    }
+};
+
+// offsets 1, 3, 6, 10, ... (triangular numbers) from the home slot, which breaks up runs; they
+// reach every slot only in a power-of-two table, so sizes are rounded up to one
+struct Quadratic_Probing
+{
+    using size_type = std::size_t;
+
+    static constexpr bool power_of_two = true;
+
+    static constexpr size_type capacity(size_type n)
+    {
+        size_type size = 1;
+        while(size < n)
+            size <<= 1;
+        return size;
+    }
+
+    static constexpr size_type stride(size_type, size_type)
+    {
+        return 1;
+    }
+
+    static constexpr size_type next(size_type index, size_type attempt, size_type, size_type size)
+    {
+        return (index + attempt) % size;
+    }
+};
+
+// steps by an odd stride taken from other bits of the hash, so keys sharing a home slot follow
+// different sequences; an odd stride reaches every slot of a power-of-two table
+struct Double_Hashing
+{
+    using size_type = std::size_t;
+
+    static constexpr bool power_of_two = true;
+
+    static constexpr size_type capacity(size_type n)
+    {
+        return Quadratic_Probing::capacity(n);
+    }
+
+    static constexpr size_type stride(size_type hash, size_type size)
+    {
+        return static_cast<size_type>(((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 32) | 1) % size;
+    }
+
+    static constexpr size_type next(size_type index, size_type, size_type stride, size_type size)
+    {
+        return (index + stride) % size;
+    }
+};
+
+template<typename _Tp, std::size_t N = 100, typename Probe = Linear_Probing, typename = void>
+class Hashtable_Probing : public Hashing<_Tp, N>
+{
+ public:
+    using value_type = _Tp;
+    using reference = _Tp&;
+    using const_reference = const _Tp&;
+    using size_type = std::size_t;
+    static const size_type npos = -1;
+
+ private:
+    class data_wrapper
+    {
+     private:
+        value_type* data;
+        size_type hash;
+        bool flag;
+
+     public:
+        data_wrapper() : data(nullptr), hash(0), flag(false) {}
+
+        data_wrapper(const_reference value, size_type _hash) : data(new value_type(value)), hash(_hash), flag(true) {}
+
+        virtual ~data_wrapper() { delete_data(); flag = false; }
+
+        // a tombstone (flag set, no data) stays a tombstone, so that segments cloned by Cow_Array keep
+        // the probe sequences running past it
+        data_wrapper(const data_wrapper& other) : data(nullptr), hash(other.hash), flag(other.flag)
+        {
+            if(other.data != nullptr)
+                data = new value_type(*other.data);
+        }
+
+        data_wrapper(data_wrapper&& other) noexcept : data(other.data), hash(other.hash), flag(other.flag) { other.data = nullptr; other.flag = false; }
+
+        data_wrapper& operator=(const data_wrapper& other)
+        {
+            if(this == &other)
+                return *this;
+
+            delete_data();
+            hash = other.hash;
+
+            data = (other.data != nullptr) ? new value_type(*other.data) : nullptr;
+            flag = other.flag;
+
+            return *this;
+        }
+
+        data_wrapper& operator=(data_wrapper&& other) noexcept
+        {
+            delete_data();
+            data = other.data;
+            hash = other.hash;
+            flag = other.flag;
+            other.data = nullptr;
+            other.flag = false;
+            return *this;
+        }
+
+        void delete_data()
+        {
+            if(data != nullptr)
+            {
+                delete data;
+                data = nullptr;
+            }
+        }
+
+        constexpr void set_data(const_reference value, size_type _hash)
+        {
+            if(!data)
+            {
+                data = new value_type(value);
+                flag = true;
+            }
+            else
+            {
+                *data = value;
+            }
+            hash = _hash;
+        }
+
+        constexpr reference get_data()
+        {
+            return *data;
+        }
+
+        constexpr const_reference get_data() const
+        {
+            return *data;
+        }
+
+        constexpr size_type get_hash() const
+        {
+            return hash;
+        }
+
+        // the stored hash is checked first, so only entries with matching hashes are dereferenced
+        constexpr bool holds(const_reference value, size_type _hash) const
+        {
+            return data != nullptr && hash == _hash && *data == value;
+        }
+
+        constexpr void to_blank()
+        {
+            if(data != nullptr)
+            {
+                delete data;
+                data = nullptr;
+            }
+            flag = false;
+        }
+
+        constexpr bool is_tombstone() const
+        {
+            return (data == nullptr && flag == true) ? true : false;
+        }
+
+        constexpr bool is_blank() const
+        {
+            return (data == nullptr && flag == false) ? true : false;
+        }
+
+        constexpr bool is_full() const
+        {
+            return (data != nullptr) ? true : false;
+        }
+    };
+
+ protected:
+    Cow_Array<data_wrapper> arr;
+    size_type counter;
+    Blocked_Bloom_Filter* filter;
+    size_type table_size;
+    Memory_Resource* resource;
+
+ private:
+    // Full_Hash is the identity for integers, so keys on a stride that divides the slot count would
+    // share one home slot and one probe sequence; the hash is mixed first, then masked when the
+    // policy keeps a power-of-two table
+    size_type home_of(size_type hash, size_type size) const
+    {
+        size_type mixed = static_cast<size_type>(this->Mix_Hash(hash));
+        return (Probe::power_of_two) ? mixed & (size - 1) : mixed % size;
+    }
+
+    size_type index_of(size_type hash) const
+    {
+        return home_of(hash, table_size);
+    }
+
+    // move every full entry into a new array of slots, placed by its stored hash;
+    // tombstones are dropped and no key is rehashed or copied
+    void rebuild(size_type new_size)
+    {
+        new_size = Probe::capacity(new_size);
+        Cow_Array<data_wrapper> new_arr(resource, new_size);
+        // keys still shared with a snapshot are copied, the others are moved
+        bool shared = arr.shared();
+
+        for(size_type i = 0; i < table_size; i++)
+        {
+            if(!arr[i].is_full())
+                continue;
+
+            size_type stride = Probe::stride(arr[i].get_hash(), new_size);
+            size_type index = home_of(arr[i].get_hash(), new_size);
+            for(size_type attempt = 1; !new_arr[index].is_blank(); attempt++)
+                index = Probe::next(index, attempt, stride, new_size);
+
+            if(shared)
+                new_arr.write(index) = arr[i];
+            else
+                new_arr.write(index) = std::move(arr.write(i));
+        }
+
+        arr = std::move(new_arr);
+        table_size = new_size;
+
+        if(filter != nullptr)
+            enable_filter(filter->false_positive_rate());
+    }
+
+ public:
+    Hashtable_Probing() : Hashtable_Probing(Memory_Resource::default_resource()) {}
+
+    explicit Hashtable_Probing(Memory_Resource* memory) : arr(), counter(0), filter(nullptr), table_size(Probe::capacity(N)), resource(memory)
+    {
+        static_assert(N != 0, "Size of the table cannot be 0");
+        arr = Cow_Array<data_wrapper>(resource, table_size);
+    }
+
+    Hashtable_Probing(std::initializer_list<value_type> value_list, Memory_Resource* memory = Memory_Resource::default_resource())
+        : Hashtable_Probing(memory)
+    {
+        for(auto&& value : value_list)
+            insert(value);
+    }
+
+    virtual ~Hashtable_Probing()
+    {
+        counter = 0;
+        disable_filter();
+    }
+
+    // A copy is an O(1) snapshot sharing the slots with other, see Hashtable_Chaining
+    Hashtable_Probing(const Hashtable_Probing& other)
+        : arr(other.arr), counter(other.counter), filter(nullptr), table_size(other.table_size), resource(other.resource)
+    {
+        if(other.filter != nullptr)
+            filter = new Blocked_Bloom_Filter(*other.filter);
+    }
+
+    Hashtable_Probing(Hashtable_Probing&& other) noexcept
+        : arr(std::move(other.arr)), counter(other.counter), filter(other.filter), table_size(other.table_size), resource(other.resource)
+    {
+        other.counter = 0;
+        other.filter = nullptr;
+    }
+
+    Hashtable_Probing& operator=(const Hashtable_Probing& other)
+    {
+        if(this == &other)
+            return *this;
+
+        // keeps this table's resource, see Hashtable_Chaining
+        arr = Cow_Array<data_wrapper>(other.arr, resource);
+        counter = other.counter;
+        table_size = other.table_size;
+
+        delete filter;
+        filter = (other.filter != nullptr) ? new Blocked_Bloom_Filter(*other.filter) : nullptr;
+        return *this;
+    }
+
+    Hashtable_Probing& operator=(Hashtable_Probing&& other) noexcept
+    {
+        if(this == &other)
+            return *this;
+
+        delete filter;
+
+        arr = std::move(other.arr);
+        counter = other.counter;
+        filter = other.filter;
+        table_size = other.table_size;
+        resource = other.resource;
+        other.counter = 0;
+        other.filter = nullptr;
+        return *this;
+    }
+
+    // Put a counting Bloom filter in front of the slots, so that most searches for absent
+    // keys stop after one cache line instead of walking a probe sequence.
+    void enable_filter(double false_positive_rate = 0.01, size_type expected_keys = 0)
+    {
+        disable_filter();
+        filter = new Blocked_Bloom_Filter(std::max(expected_keys, table_size), false_positive_rate);
+
+        for(size_type i = 0; i < table_size; i++)
+        {
+            if(arr[i].is_full())
+                filter->insert(arr[i].get_hash());
+        }
+    }
+
+    void disable_filter()
+    {
+        if(filter != nullptr)
+        {
+            delete filter;
+            filter = nullptr;
+        }
+    }
+
+    bool has_filter() const
+    {
+        return (filter != nullptr) ? true : false;
+    }
+
+    // empties the slots in place, see Hashtable_Chaining::clear
+    void clear()
+    {
+        if(!arr.shared())
+        {
+            for(size_type i = 0; i < table_size; i++)
+            {
+                if(!arr[i].is_blank())
+                    arr.write(i).to_blank();
+            }
+        }
+        else
+        {
+            arr = Cow_Array<data_wrapper>();
+            arr = Cow_Array<data_wrapper>(resource, table_size);
+        }
+
+        counter = 0;
+
+        if(filter != nullptr)
+            filter->clear();
+    }
+
+    size_type count() const
+    {
+        return counter;
+    }
+
+    size_type size() const
+    {
+        return table_size;
+    }
+
+    bool empty() const
+    {
+        return (counter == 0) ? true : false;
+    }
+
+    bool full() const
+    {
+        return (counter == table_size) ? true : false;
+    }
+
+    // make room for n keys while keeping the load at or below 3/4
+    void reserve(size_type n)
+    {
+        // 4n/3 rounded up: rounding down would leave the load above 3/4
+        size_type needed = (4 * n + 2) / 3;
+        if(needed > table_size)
+            rebuild(needed);
+    }
+
+    // repack the keys into as few slots as a 3/4 load allows, dropping all tombstones
+    void shrink_to_fit()
+    {
+        size_type needed = std::max((4 * counter + 2) / 3, size_type(1));
+        rebuild(std::min(needed, table_size));
+    }
+
+    // bytes held by the table: slot array, keys with their heap buffers, and the filter
+    size_type memory_usage() const
+    {
+        size_type bytes = sizeof(*this) + arr.memory_usage() + counter * sizeof(value_type);
+        for(size_type i = 0; i < table_size; i++)
+        {
+            if(arr[i].is_full())
+                bytes += this->External_Bytes(arr[i].get_data());
+        }
+        return (filter != nullptr) ? bytes + filter->memory_usage() : bytes;
+    }
+
+    // mean number of slots a successful search inspects, for comparing probe policies on a workload
+    double average_probe_length() const
+    {
+        if(counter == 0)
+            return 0;
+
+        size_type probes = 0;
+        for(size_type i = 0; i < table_size; i++)
+        {
+            if(!arr[i].is_full())
+                continue;
+
+            size_type stride = Probe::stride(arr[i].get_hash(), table_size);
+            size_type index = index_of(arr[i].get_hash());
+            size_type attempt = 0;
+            while(index != i)
+                index = Probe::next(index, ++attempt, stride, table_size);
+            probes += attempt + 1;
+        }
+        return static_cast<double>(probes) / counter;
+    }
+
+ private:
+    friend class Set_Operations<Hashtable_Probing>;
+
+    size_type hash_of(const_reference value) const
+    {
+        return this->Full_Hash(value);
+    }
+
+    bool same_hasher(const Hashtable_Probing&) const
+    {
+        return true;
+    }
+
+    size_type slot_count() const
+    {
+        return table_size;
+    }
+
+    // calls f(key, stored hash) for every key in the slots [first, last)
+    template<typename Function>
+    void for_each_hashed(size_type first, size_type last, Function f) const
+    {
+        for(size_type i = first; i < last; i++)
+        {
+            if(arr[i].is_full())
+                f(arr[i].get_data(), arr[i].get_hash());
+        }
+    }
+
+    void prefetch_hashed(size_type hash) const
+    {
+        Set_Operations<Hashtable_Probing>::prefetch(&arr[index_of(hash)]);
+    }
+
+    bool insert_hashed(const_reference value, size_type hash)
+    {
+        // If the table is already fulfilled, do nothing
+        if(this->full())
+            return false;
+
+        size_type tomb_note = npos;
+        size_type search_counter = 0;
+        size_type stride = Probe::stride(hash, table_size);
+        size_type index = index_of(hash);
+
+        while(!arr[index].is_blank() && search_counter != table_size)
+        {
+            // If an entry with this value is already exist, don't attempt to insert anymore
+            if(arr[index].holds(value, hash))
+            {
+                break;
+            }
+            // If a tombstone is found, store this tombstone entry
+            else if(arr[index].is_tombstone() && tomb_note == npos)
+            {
+                tomb_note = index;
+            }
+
+            search_counter++;
+            index = Probe::next(index, search_counter, stride, table_size);
+        }
+
+        if(!arr[index].is_blank() && search_counter != table_size)
+        {
+            return false;
+        }
+        else if(arr[index].is_blank() && tomb_note != npos && search_counter != table_size)
+        {
+            arr.write(tomb_note).set_data(value, hash);
+            counter++;
+            if(filter != nullptr)
+                filter->insert(hash);
+            return true;
+        }
+        else if(arr[index].is_blank() && tomb_note == npos && search_counter != table_size)
+        {
+            arr.write(index).set_data(value, hash);
+            counter++;
+            if(filter != nullptr)
+                filter->insert(hash);
+            return true;
+        }
+        else
+        {
+            arr.write(tomb_note).set_data(value, hash);
+            counter++;
+            if(filter != nullptr)
+                filter->insert(hash);
+            return true;
+        }
+    }
+
+    bool contains_hashed(const_reference value, size_type hash) const
+    {
+        // search_counter is used to avoid infinite loop
+        size_type search_counter = 0;
+
+        if(filter != nullptr && !filter->may_contain(hash))
+            return false;
+
+        size_type stride = Probe::stride(hash, table_size);
+        size_type index = index_of(hash);
+        while(!arr[index].is_blank() && search_counter != table_size)
+        {
+            // If an entry with this value is found, stop traversing
+            if(arr[index].holds(value, hash))
+                break;
+
+            search_counter++;
+            index = Probe::next(index, search_counter, stride, table_size);
+        }
+
+        // false when the fulfilled table does not contain the value
+        if(search_counter == table_size)
+        {
+            return false;
+        }
+        // false when stop at blank wrapper
+        else if(search_counter != table_size && arr[index].is_blank())
+        {
+            return false;
+        }
+        // otherwise, if the current index is a full entry, the value is found
+        else
+        {
+            return true;
+        }
+    }
+
+    size_type erase_hashed(const_reference value, size_type hash)
+    {
+        // search_counter is used to avoid infinite loop
+        size_type search_counter = 0;
+
+        size_type stride = Probe::stride(hash, table_size);
+        size_type index = index_of(hash);
+        while(!arr[index].is_blank() && search_counter != table_size)
+        {
+            // If an entry with this value is found, stop traversing
+            if(arr[index].holds(value, hash))
+                break;
+
+            search_counter++;
+            index = Probe::next(index, search_counter, stride, table_size);
+        }
+
+        // do nothing when the fulfilled table does not contain the value
+        if(search_counter == table_size)
+        {
+            return 0;
+        }
+        // do nothing when stop at blank wrapper
+        else if(search_counter != table_size && arr[index].is_blank())
+        {
+            return 0;
+        }
+        // otherwise, this is the entry to be deleted
+        else
+        {
+            arr.write(index).delete_data();
+            counter--;
+            if(filter != nullptr)
+                filter->erase(hash);
+            return 1;
+        }
+    }
+
+ public:
+    bool insert(const_reference value)
+    {
+        return insert_hashed(value, this->Full_Hash(value));
+    }
+
+    bool search(const_reference value) const
+    {
+        return contains_hashed(value, this->Full_Hash(value));
+    }
+
+    size_type erase(const_reference value)
+    {
+        return erase_hashed(value, this->Full_Hash(value));
+    }
+
+    // Set algebra with another table, see Hashtable_Chaining::merge. Keys that do not fit
+    // into a fulfilled table are not inserted.
+    size_type merge(const Hashtable_Probing& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::merge(*this, other, threads);
+    }
+
+    size_type intersect_with(const Hashtable_Probing& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::intersect(*this, other, threads);
+    }
+
+    size_type difference(const Hashtable_Probing& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::difference(*this, other, threads);
+    }
+
+    static Hashtable_Probing union_of(const Hashtable_Probing& first, const Hashtable_Probing& second, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::union_of(first, second, threads);
+    }
+
+    void display(std::ostream& out) const
+    {
+        for(size_type i = 0; i < table_size; i++)
+        {
+            if(arr[i].is_full())
+                out << "Entry #" << i + 1 << ":  " << arr[i].get_data() << "\n";
+        }
+    }
+
+    void display() const
+    {
+        return display(std::cout);
+    }
+};
+
+// Specialization for integral keys: the keys are stored directly in a flat array, and two
+// reserved key values mark empty and deleted slots, so a cache line holds 8 (64-bit) keys and
+// inserting never allocates. Keys equal to a reserved value are kept aside in a side slot.
+template<typename _Tp, std::size_t N, typename Probe>
+class Hashtable_Probing<_Tp, N, Probe, typename std::enable_if<std::is_integral<_Tp>::value && !std::is_same<_Tp, bool>::value>::type>
+    : public Hashing<_Tp, N>
+{
+ public:
+    using value_type = _Tp;
+    using reference = _Tp&;
+    using const_reference = const _Tp&;
+    using size_type = std::size_t;
+    static const size_type npos = -1;
+
+ protected:
+    Cow_Array<value_type> arr;
+    size_type counter;
+    value_type empty_key;
+    value_type deleted_key;
+    bool has_empty_key;
+    bool has_deleted_key;
+    Blocked_Bloom_Filter* filter;
+    size_type table_size;
+    Memory_Resource* resource;
+
+ private:
+    // mixed first, see the generic table
+    size_type home_of(size_type hash, size_type size) const
+    {
+        size_type mixed = static_cast<size_type>(this->Mix_Hash(hash));
+        return (Probe::power_of_two) ? mixed & (size - 1) : mixed % size;
+    }
+
+    size_type index_of(size_type hash) const
+    {
+        return home_of(hash, table_size);
+    }
+
+    // place every key into a new array of slots, dropping all tombstones
+    void rebuild(size_type new_size)
+    {
+        new_size = Probe::capacity(new_size);
+        Cow_Array<value_type> new_arr(resource, new_size, empty_key);
+
+        for(size_type i = 0; i < table_size; i++)
         {
-            clear();
-            head = other.head;
-            tail = other.tail;
-            other.head = nullptr;
-            other.tail = nullptr;
-            return (*this);
+            if(is_reserved(arr[i]))
+                continue;
+
+            size_type hash = this->Full_Hash(arr[i]);
+            size_type stride = Probe::stride(hash, new_size);
+            size_type index = home_of(hash, new_size);
+            for(size_type attempt = 1; new_arr[index] != empty_key; attempt++)
+                index = Probe::next(index, attempt, stride, new_size);
+            new_arr.write(index) = arr[i];
         }
 
-        virtual ~DoublyLinkedList()
+        arr = std::move(new_arr);
+        table_size = new_size;
+
+        if(filter != nullptr)
+            enable_filter(filter->false_positive_rate());
+    }
+
+    bool is_reserved(value_type value) const
+    {
+        return (value == empty_key || value == deleted_key) ? true : false;
+    }
+
+    bool& side_slot(value_type value)
+    {
+        return (value == empty_key) ? has_empty_key : has_deleted_key;
+    }
+
+    bool side_slot(value_type value) const
+    {
+        return (value == empty_key) ? has_empty_key : has_deleted_key;
+    }
+
+    // number of keys held in the array itself
+    size_type slots_used() const
+    {
+        return counter - has_empty_key - has_deleted_key;
+    }
+
+    // index of value in the array, or npos when it is absent
+    size_type find_index(value_type value, size_type hash) const
+    {
+        // search_counter is used to avoid infinite loop
+        size_type search_counter = 0;
+        size_type stride = Probe::stride(hash, table_size);
+        size_type index = index_of(hash);
+
+        while(arr[index] != empty_key && search_counter != table_size)
         {
-            clear();
+            if(arr[index] == value)
+                return index;
+
+            search_counter++;
+            index = Probe::next(index, search_counter, stride, table_size);
+        }
+        return npos;
+    }
+
+ public:
+    Hashtable_Probing() : Hashtable_Probing(std::numeric_limits<_Tp>::max(), std::numeric_limits<_Tp>::max() - 1) {}
+
+    explicit Hashtable_Probing(Memory_Resource* memory)
+        : Hashtable_Probing(std::numeric_limits<_Tp>::max(), std::numeric_limits<_Tp>::max() - 1, memory) {}
+
+    // the two reserved values must differ; they can still be stored, they just live outside the array
+    Hashtable_Probing(value_type empty_value, value_type deleted_value, Memory_Resource* memory = Memory_Resource::default_resource())
+        : arr(), counter(0), empty_key(empty_value), deleted_key(deleted_value),
+          has_empty_key(false), has_deleted_key(false), filter(nullptr), table_size(Probe::capacity(N)), resource(memory)
+    {
+        static_assert(N != 0, "Size of the table cannot be 0");
+        if(empty_key == deleted_key)
+            throw std::invalid_argument("Hashtable_Probing: empty and deleted keys must differ");
+
+        arr = Cow_Array<value_type>(resource, table_size, empty_key);
+    }
+
+    Hashtable_Probing(std::initializer_list<value_type> value_list, Memory_Resource* memory = Memory_Resource::default_resource())
+        : Hashtable_Probing(memory)
+    {
+        for(auto&& value : value_list)
+            insert(value);
+    }
+
+    virtual ~Hashtable_Probing()
+    {
+        counter = 0;
+        disable_filter();
+    }
+
+    // A copy is an O(1) snapshot sharing the slots with other, see Hashtable_Chaining
+    Hashtable_Probing(const Hashtable_Probing& other)
+        : arr(other.arr), counter(other.counter), empty_key(other.empty_key), deleted_key(other.deleted_key),
+          has_empty_key(other.has_empty_key), has_deleted_key(other.has_deleted_key), filter(nullptr),
+          table_size(other.table_size), resource(other.resource)
+    {
+        if(other.filter != nullptr)
+            filter = new Blocked_Bloom_Filter(*other.filter);
+    }
+
+    Hashtable_Probing(Hashtable_Probing&& other) noexcept
+        : arr(std::move(other.arr)), counter(other.counter), empty_key(other.empty_key), deleted_key(other.deleted_key),
+          has_empty_key(other.has_empty_key), has_deleted_key(other.has_deleted_key), filter(other.filter),
+          table_size(other.table_size), resource(other.resource)
+    {
+        other.counter = 0;
+        other.has_empty_key = other.has_deleted_key = false;
+        other.filter = nullptr;
+    }
+
+    Hashtable_Probing& operator=(const Hashtable_Probing& other)
+    {
+        if(this == &other)
+            return *this;
+
+        // keeps this table's resource, see Hashtable_Chaining
+        arr = Cow_Array<value_type>(other.arr, resource);
+        counter = other.counter;
+        table_size = other.table_size;
+        empty_key = other.empty_key;
+        deleted_key = other.deleted_key;
+        has_empty_key = other.has_empty_key;
+        has_deleted_key = other.has_deleted_key;
+
+        delete filter;
+        filter = (other.filter != nullptr) ? new Blocked_Bloom_Filter(*other.filter) : nullptr;
+        return *this;
+    }
+
+    Hashtable_Probing& operator=(Hashtable_Probing&& other) noexcept
+    {
+        if(this == &other)
+            return *this;
+
+        delete filter;
+
+        arr = std::move(other.arr);
+        counter = other.counter;
+        table_size = other.table_size;
+        resource = other.resource;
+        empty_key = other.empty_key;
+        deleted_key = other.deleted_key;
+        has_empty_key = other.has_empty_key;
+        has_deleted_key = other.has_deleted_key;
+        filter = other.filter;
+        other.counter = 0;
+        other.has_empty_key = other.has_deleted_key = false;
+        other.filter = nullptr;
+        return *this;
+    }
+
+    void enable_filter(double false_positive_rate = 0.01, size_type expected_keys = 0)
+    {
+        disable_filter();
+        filter = new Blocked_Bloom_Filter(std::max(expected_keys, table_size), false_positive_rate);
+
+        for(size_type i = 0; i < table_size; i++)
+        {
+            if(!is_reserved(arr[i]))
+                filter->insert(this->Full_Hash(arr[i]));
+        }
+    }
+
+    void disable_filter()
+    {
+        if(filter != nullptr)
+        {
+            delete filter;
+            filter = nullptr;
+        }
+    }
+
+    bool has_filter() const
+    {
+        return (filter != nullptr) ? true : false;
+    }
+
+    // empties the slots in place, see Hashtable_Chaining::clear
+    void clear()
+    {
+        if(!arr.shared())
+        {
+            for(size_type i = 0; i < table_size; i++)
+            {
+                if(arr[i] != empty_key)
+                    arr.write(i) = empty_key;
+            }
+        }
+        else
+        {
+            arr = Cow_Array<value_type>();
+            arr = Cow_Array<value_type>(resource, table_size, empty_key);
+        }
+
+        counter = 0;
+        has_empty_key = has_deleted_key = false;
+
+        if(filter != nullptr)
+            filter->clear();
+    }
+
+    size_type count() const
+    {
+        return counter;
+    }
+
+    size_type size() const
+    {
+        return table_size;
+    }
+
+    bool empty() const
+    {
+        return (counter == 0) ? true : false;
+    }
+
+    bool full() const
+    {
+        return (slots_used() == table_size) ? true : false;
+    }
+
+    // make room for n keys while keeping the load at or below 3/4
+    void reserve(size_type n)
+    {
+        // 4n/3 rounded up: rounding down would leave the load above 3/4
+        size_type needed = (4 * n + 2) / 3;
+        if(needed > table_size)
+            rebuild(needed);
+    }
+
+    // repack the keys into as few slots as a 3/4 load allows, dropping all tombstones
+    void shrink_to_fit()
+    {
+        size_type needed = std::max((4 * slots_used() + 2) / 3, size_type(1));
+        rebuild(std::min(needed, table_size));
+    }
+
+    // bytes held by the table: slot array and filter
+    size_type memory_usage() const
+    {
+        size_type bytes = sizeof(*this) + arr.memory_usage();
+        return (filter != nullptr) ? bytes + filter->memory_usage() : bytes;
+    }
+
+    // mean number of slots a successful search in the array inspects, for comparing probe policies
+    double average_probe_length() const
+    {
+        if(slots_used() == 0)
+            return 0;
+
+        size_type probes = 0;
+        for(size_type i = 0; i < table_size; i++)
+        {
+            if(is_reserved(arr[i]))
+                continue;
+
+            size_type hash = this->Full_Hash(arr[i]);
+            size_type stride = Probe::stride(hash, table_size);
+            size_type index = index_of(hash);
+            size_type attempt = 0;
+            while(index != i)
+                index = Probe::next(index, ++attempt, stride, table_size);
+            probes += attempt + 1;
+        }
+        return static_cast<double>(probes) / slots_used();
+    }
+
+    value_type empty_value() const
+    {
+        return empty_key;
+    }
+
+    value_type deleted_value() const
+    {
+        return deleted_key;
+    }
+
+ private:
+    friend class Set_Operations<Hashtable_Probing>;
+
+    size_type hash_of(const_reference value) const
+    {
+        return this->Full_Hash(value);
+    }
+
+    bool same_hasher(const Hashtable_Probing&) const
+    {
+        return true;
+    }
+
+    // the reserved keys are visited by the first range
+    size_type slot_count() const
+    {
+        return table_size;
+    }
+
+    // calls f(key, hash) for every key in the slots [first, last); the hash is not stored but
+    // is cheap to recompute for integers
+    template<typename Function>
+    void for_each_hashed(size_type first, size_type last, Function f) const
+    {
+        if(first == 0)
+        {
+            if(has_empty_key)
+                f(empty_key, this->Full_Hash(empty_key));
+            if(has_deleted_key)
+                f(deleted_key, this->Full_Hash(deleted_key));
+        }
+
+        for(size_type i = first; i < last; i++)
+        {
+            if(!is_reserved(arr[i]))
+                f(arr[i], this->Full_Hash(arr[i]));
+        }
+    }
+
+    void prefetch_hashed(size_type hash) const
+    {
+        Set_Operations<Hashtable_Probing>::prefetch(&arr[index_of(hash)]);
+    }
+
+    bool insert_hashed(const_reference value, size_type hash)
+    {
+        if(is_reserved(value))
+        {
+            bool& stored = side_slot(value);
+            if(stored)
+                return false;
+
+            stored = true;
+            counter++;
+            return true;
+        }
+
+        // If the table is already fulfilled, do nothing
+        if(this->full())
+            return false;
+
+        size_type tomb_note = npos;
+        size_type search_counter = 0;
+        size_type stride = Probe::stride(hash, table_size);
+        size_type index = index_of(hash);
+
+        while(arr[index] != empty_key && search_counter != table_size)
+        {
+            // If an entry with this value is already exist, don't attempt to insert anymore
+            if(arr[index] == value)
+                return false;
+            // If a tombstone is found, store this tombstone entry
+            else if(arr[index] == deleted_key && tomb_note == npos)
+                tomb_note = index;
+
+            search_counter++;
+            index = Probe::next(index, search_counter, stride, table_size);
+        }
+
+        arr.write((tomb_note != npos) ? tomb_note : index) = value;
+        counter++;
+        if(filter != nullptr)
+            filter->insert(hash);
+        return true;
+    }
+
+    bool contains_hashed(const_reference value, size_type hash) const
+    {
+        if(is_reserved(value))
+            return side_slot(value);
+
+        if(filter != nullptr && !filter->may_contain(hash))
+            return false;
+
+        return (find_index(value, hash) != npos) ? true : false;
+    }
+
+    size_type erase_hashed(const_reference value, size_type hash)
+    {
+        if(is_reserved(value))
+        {
+            bool& stored = side_slot(value);
+            if(!stored)
+                return 0;
+
+            stored = false;
+            counter--;
+            return 1;
         }
 
-        void clear()
+        size_type index = find_index(value, hash);
+        if(index == npos)
+            return 0;
+
+        arr.write(index) = deleted_key;
+        counter--;
+        if(filter != nullptr)
+            filter->erase(hash);
+        return 1;
+    }
+
+ public:
+    bool insert(const_reference value)
+    {
+        return insert_hashed(value, this->Full_Hash(value));
+    }
+
+    bool search(const_reference value) const
+    {
+        return contains_hashed(value, this->Full_Hash(value));
+    }
+
+    size_type erase(const_reference value)
+    {
+        return erase_hashed(value, this->Full_Hash(value));
+    }
+
+    // Set algebra with another table, see Hashtable_Chaining::merge
+    size_type merge(const Hashtable_Probing& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::merge(*this, other, threads);
+    }
+
+    size_type intersect_with(const Hashtable_Probing& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::intersect(*this, other, threads);
+    }
+
+    size_type difference(const Hashtable_Probing& other, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::difference(*this, other, threads);
+    }
+
+    static Hashtable_Probing union_of(const Hashtable_Probing& first, const Hashtable_Probing& second, size_type threads = 1)
+    {
+        return Set_Operations<Hashtable_Probing>::union_of(first, second, threads);
+    }
+
+    void display(std::ostream& out) const
+    {
+        for(size_type i = 0; i < table_size; i++)
         {
-            if(length)
-            {
-                Node_ptr current = head;
-                while(current)
-                {
-                    Node_ptr delTmp = current;
-                    current = current->getNext();
-                    delete delTmp;
-                }
-                head = tail = nullptr; length = 0;
-            }
+            if(!is_reserved(arr[i]))
+                out << "Entry #" << i + 1 << ":  " << arr[i] << "\n";
         }
+        if(has_empty_key)
+            out << "Reserved entry:  " << empty_key << "\n";
+        if(has_deleted_key)
+            out << "Reserved entry:  " << deleted_key << "\n";
+    }
 
-        constexpr void push_front(const_reference value)
-        {
-            if(!length){
-                head = MakeNode(value);
-                length++;
-                tail = head;
-            } else {
-                head->createPrevious(value);
-                length++;
-                head = head->getPrevious();
-            }
-        }
+    void display() const
+    {
+        return display(std::cout);
+    }
+};
 
-        constexpr void push_back(const_reference value)
-        {
-            if(!length){
-                head = MakeNode(value);
-                length++;
-                tail = head;
-            }
-            else {
-                tail->createNext(value);
-                length++;
-                tail = tail->getNext();
-            }
-        }
+// Chained table that allows duplicate keys. Each distinct key is stored once together with the
+// number of times it occurs, so a hot key costs one node however often it is inserted.
+template<typename _Tp, std::size_t N = 100>
+class Hashtable_Multiset : public Hashing<_Tp, N>
+{
+ public:
+    using value_type = _Tp;
+    using reference = _Tp&;
+    using const_reference = const _Tp&;
+    using size_type = std::size_t;
 
-        constexpr void pop_front()
-        {
-            if(!length){
-                return;
-            }
-            else if(length == 1){
-                delete head;
-                length--;
-                head = tail = nullptr;
-            }
-            else{
-                Node_ptr tmp = head;
-                head = head->getNext();
-                delete tmp;
-                length--;
-            }
-        }
+ private:
+    class Node
+    {
+     public:
+        value_type key;
+        size_type hash;
+        size_type count;
+        Node* next;
 
-        constexpr void pop_back()
-        {
-            if(!length){
-                return;
-            }
-            else if(length == 1){
-                delete head;
-                length--;
-                head = tail = nullptr;
-            }
-            else{
-                Node_ptr tmp = tail;
-                tail = tail->getPrevious();
-                delete tmp;
-                length--;
-            }
-        }
+        Node(const_reference _key, size_type _hash, size_type _count, Node* _next)
+            : key(_key), hash(_hash), count(_count), next(_next) {}
+    };
 
-        constexpr Node_ptr search(const_reference value) const
-        {
-            Node_ptr current = head;
-            while(current)
-            {
-                if(current->getKey() == value){
-                    return current;
-                }
-                current = current->getNext();
-            }
-            return nullptr;
-        }
+ public:
+    // visits one group of equal keys, yielding the key once per occurrence
+    class const_iterator
+    {
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = _Tp;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const _Tp*;
+        using reference = const _Tp&;
 
-        constexpr size_type erase(const_reference value)
-        {
-            size_type count = 0;
-            Node_ptr current = head;
-            while(current)
-            {
-                if(current->getKey() == value)
-                {
-                    Node_ptr temp = current;
-                    if(temp == head){
-                        current = current->getNext();
-                        pop_front();
-                    }
-                    else if(temp == tail){
-                        current = current->getNext();
-                        pop_back();
-                    }
-                    else{
-                        Node_ptr tmp_prev = temp->getPrevious();
-                        current =  temp->getNext();
-                        current->setPrevious(tmp_prev);
-                        tmp_prev->setNext(current);
+     private:
+        pointer key;
+        size_type position;
 
-                        delete temp;
-                        length--;
-                    }
-                    count++;
-                }
-                else{
-                    current = current->getNext();
-                }
-            }
-            return count;
-        }
+     public:
+        const_iterator() : key(nullptr), position(0) {}
+        const_iterator(const _Tp* _key, size_type _position) : key(_key), position(_position) {}
 
-        constexpr void display(std::ostream& out) const
-        {
-            if(empty())
-                return;
+        reference operator*() const { return *key; }
+        pointer operator->() const { return key; }
 
-            Node_ptr current = head;
-            while(current->getNext()){
-                out << current->getKey() << " -> ";
-                current = current->getNext();
-            }
-            out << current->getKey();
-            out << '\n';
+        const_iterator& operator++()
+        {
+            position++;
+            return *this;
         }
 
-        constexpr void display() const
+        const_iterator operator++(int)
         {
-            display(std::cout);
+            const_iterator previous = *this;
+            position++;
+            return previous;
         }
 
-        constexpr bool empty() const
+        bool operator==(const const_iterator& other) const
         {
-            return (!length) ? true : false;
+            return key == other.key && position == other.position;
         }
 
-        constexpr size_type size() const
+        bool operator!=(const const_iterator& other) const
         {
-            return length;
+            return !(*this == other);
         }
     };
 
- public:
-    using DLL_ptr = DoublyLinkedList*;
-    using Node_ptr = typename DoublyLinkedList::Node_ptr;
-    using Const_Node_ptr = typename DoublyLinkedList::ConstNPtr;
-
  protected:
-    DLL_ptr arr;
+    Node** arr;
     size_type counter;
+    size_type distinct_counter;
 
- public:
-    constexpr Hashtable_Chaining() : arr(new DoublyLinkedList[N]), counter(0) {}
+ private:
+    Node* find_node(const_reference value, size_type hash) const
+    {
+        for(Node* current = arr[this->Hash_Index(hash)]; current; current = current->next)
+        {
+            if(current->hash == hash && current->key == value)
+                return current;
+        }
+        return nullptr;
+    }
 
-    constexpr Hashtable_Chaining(std::initializer_list<value_type> initList) : Hashtable_Chaining()
+    size_type insert_hashed(const_reference value, size_type hash, size_type copies)
     {
-        for(auto&& value : initList){
-            insert(value);
+        Node* node = find_node(value, hash);
+        if(node)
+        {
+            node->count += copies;
+        }
+        else
+        {
+            size_type index = this->Hash_Index(hash);
+            node = new Node(value, hash, copies, arr[index]);
+            arr[index] = node;
+            distinct_counter++;
         }
+        counter += copies;
+        return node->count;
     }
 
-    constexpr Hashtable_Chaining(const Hashtable_Chaining& other) noexcept : Hashtable_Chaining()
+    void copy_from(const Hashtable_Multiset& other)
     {
-        for(size_type i = 0; i < N; ++i) {
-            arr[i] = other.arr[i];
+        for(size_type i = 0; i < N; ++i)
+        {
+            for(Node* current = other.arr[i]; current; current = current->next)
+                arr[i] = new Node(current->key, current->hash, current->count, arr[i]);
         }
         counter = other.counter;
+        distinct_counter = other.distinct_counter;
     }
 
-    constexpr Hashtable_Chaining(Hashtable_Chaining&& other) noexcept : arr(std::move(other.arr)), counter(std::move(other.arr_cout)) {}
+ public:
+    Hashtable_Multiset() : arr(new Node*[N]()), counter(0), distinct_counter(0) {}
 
-    constexpr Hashtable_Chaining& operator=(const Hashtable_Chaining& other)
+    Hashtable_Multiset(std::initializer_list<value_type> initList) : Hashtable_Multiset()
     {
-        if(this == &other) { return (*this); }
+        insert(initList.begin(), initList.end());
+    }
 
-        for(size_type i = 0; i < N; ++i){
-            arr[i] = other.arr[i];
-        }
-        counter = other.counter;
+    Hashtable_Multiset(const Hashtable_Multiset& other) : Hashtable_Multiset()
+    {
+        copy_from(other);
+    }
 
-        return (*this);
+    Hashtable_Multiset(Hashtable_Multiset&& other) noexcept
+        : arr(other.arr), counter(other.counter), distinct_counter(other.distinct_counter)
+    {
+        other.arr = nullptr;
+        other.counter = other.distinct_counter = 0;
+    }
+
+    Hashtable_Multiset& operator=(const Hashtable_Multiset& other)
+    {
+        if(this == &other)
+            return *this;
+
+        clear();
+        copy_from(other);
+        return *this;
     }
 
-    constexpr Hashtable_Chaining& operator=(Hashtable_Chaining&& other) noexcept
+    Hashtable_Multiset& operator=(Hashtable_Multiset&& other) noexcept
     {
-        this->~Hashtable_Chaining();
+        if(this == &other)
+            return *this;
+
+        if(arr)
+        {
+            clear();
+            delete[] arr;
+        }
         arr = other.arr;
         counter = other.counter;
+        distinct_counter = other.distinct_counter;
         other.arr = nullptr;
-        other.counter = 0;
-        return (*this);
+        other.counter = other.distinct_counter = 0;
+        return *this;
     }
 
-    virtual ~Hashtable_Chaining()
+    virtual ~Hashtable_Multiset()
     {
-        if(arr){
-            delete [] arr;
+        if(arr)
+        {
+            clear();
+            delete[] arr;
             arr = nullptr;
-            counter = 0;
         }
     }
 
-    constexpr size_type size()
+    // returns the number of occurrences of value after the insertion
+    size_type insert(const_reference value, size_type copies = 1)
     {
-        return counter;
-    }
+        if(copies == 0)
+            return count(value);
 
-    constexpr bool empty()
-    {
-        return (!counter) ? true : false;
+        return insert_hashed(value, this->Full_Hash(value), copies);
     }
 
-    constexpr bool insert(const_reference value)
+    // batch insert: runs of equal neighbouring keys are hashed and looked up only once; only
+    // iterators match, so insert(key, copies) with integral keys still picks the count overload
+    template<typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+    void insert(InputIt first, InputIt last)
     {
-        size_type index = this->Hash_Function(value);
-        if(!arr[index].search(value))
+        while(first != last)
         {
-            arr[index].push_back(value);
-            counter++;
-            return true;
-        }
-        else{
-            return false;
+            // the key is copied before the iterator moves on, so single-pass iterators work too
+            value_type value = *first;
+            size_type copies = 1;
+            for(++first; first != last && *first == value; ++first)
+                copies++;
+
+            insert_hashed(value, this->Full_Hash(value), copies);
         }
     }
 
-    constexpr bool search(const_reference value)
+    size_type count(const_reference value) const
     {
-        size_type index = this->Hash_Function(value);
-        return (arr[index].search(value) != nullptr) ? true : false;
+        Node* node = find_node(value, this->Full_Hash(value));
+        return (node) ? node->count : 0;
     }
 
-    constexpr size_type erase(const_reference value)
+    bool search(const_reference value) const
+    {
+        return (find_node(value, this->Full_Hash(value)) != nullptr) ? true : false;
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const_reference value) const
+    {
+        Node* node = find_node(value, this->Full_Hash(value));
+        if(!node)
+            return std::make_pair(const_iterator(), const_iterator());
+
+        return std::make_pair(const_iterator(&node->key, 0), const_iterator(&node->key, node->count));
+    }
+
+    // removes every occurrence of value, returning how many there were
+    size_type erase(const_reference value)
+    {
+        return erase(value, static_cast<size_type>(-1));
+    }
+
+    // removes up to copies occurrences of value, returning how many were removed
+    size_type erase(const_reference value, size_type copies)
     {
-        size_type index = this->Hash_Function(value);
-        size_type erase_count = arr[index].erase(value);
+        size_type hash = this->Full_Hash(value);
+        Node** link = &arr[this->Hash_Index(hash)];
+        while(*link && !((*link)->hash == hash && (*link)->key == value))
+            link = &(*link)->next;
+
+        if(!*link || copies == 0)
+            return 0;
+
+        Node* node = *link;
+        if(copies < node->count)
+        {
+            node->count -= copies;
+            counter -= copies;
+            return copies;
+        }
+
+        size_type erase_count = node->count;
+        *link = node->next;
+        delete node;
         counter -= erase_count;
+        distinct_counter--;
         return erase_count;
     }
 
     void clear() override
     {
-        if(counter){
-            counter = 0;
-            delete arr;
-            arr = new DoublyLinkedList[N];
+        for(size_type i = 0; i < N; ++i)
+        {
+            while(arr[i])
+            {
+                Node* delTmp = arr[i];
+                arr[i] = arr[i]->next;
+                delete delTmp;
+            }
         }
+        counter = distinct_counter = 0;
     }
 
-    constexpr void display(std::ostream& out) const
+    // total number of elements, duplicates included
+    size_type size() const
+    {
+        return counter;
+    }
+
+    size_type distinct() const
+    {
+        return distinct_counter;
+    }
+
+    bool empty() const
+    {
+        return (counter == 0) ? true : false;
+    }
+
+    void display(std::ostream& out) const
     {
         for(size_type i = 0; i < N; ++i)
         {
-            if(!arr[i].empty())
+            if(arr[i])
             {
                 out << "List #" << i + 1 << ": ";
-                arr[i].display(out);
+                for(Node* current = arr[i]; current; current = current->next)
+                    out << current->key << " (x" << current->count << ")" << ((current->next) ? " -> " : "\n");
             }
         }
     }
 
-    constexpr void display() const
+    void display() const
     {
         display(std::cout);
     }
 };
 
-template<typename _Tp, std::size_t N = 100>
-class Hashtable_Probing : public Hashing<_Tp, N>
+// Bounded cache with least-recently-used eviction. Every entry sits in its hash bucket chain
+// and in the global recency list through links stored in the same node, so get and put are a
+// single bucket lookup plus O(1) relinking. All nodes are allocated once by the constructor;
+// neither lookups nor insertions allocate, an insertion at capacity reuses the evicted node.
+template<typename _Key, typename _Val, std::size_t N = 100>
+class LRU_Cache : public Hashing<_Key, N>
 {
  public:
-    using value_type = _Tp;
-    using reference = _Tp&;
-    using const_reference = const _Tp&;
+    using key_type = _Key;
+    using mapped_type = _Val;
     using size_type = std::size_t;
-    static const size_type npos = -1;
 
  private:
-    class data_wrapper
+    class Node
     {
-     private:
-        value_type* data;
-        bool flag;
-
      public:
-        data_wrapper() : data(nullptr), flag(false) {}
+        key_type key;
+        mapped_type value;
+        size_type hash;
+        Node* chain_next;
+        Node* chain_prev;
+        Node* newer;
+        Node* older;
+
+        Node() : key(), value(), hash(0), chain_next(nullptr), chain_prev(nullptr), newer(nullptr), older(nullptr) {}
+    };
 
-        data_wrapper(const_reference value) : data(new value_type(value)), flag(true) {}
+    template<typename, typename, std::size_t, std::size_t> friend class Sharded_LRU_Cache;
 
-        virtual ~data_wrapper() { delete_data(); flag = false; }
+ protected:
+    Node** buckets;
+    Node* pool;
+    Node* free_nodes;
+    Node* most_recent;
+    Node* least_recent;
+    size_type max_size;
+    size_type counter;
+    // the bucket count grows with the capacity, so chains stay short for any capacity
+    size_type table_size;
+
+ private:
+    // Full_Hash is the identity for integers, so the hash is mixed before its low bits are taken:
+    // otherwise keys that are multiples of the power-of-two bucket count would share one chain
+    size_type index_of(size_type hash) const
+    {
+        return static_cast<size_type>(this->Mix_Hash(hash)) & (table_size - 1);
+    }
 
-        data_wrapper(const data_wrapper& other) : data(nullptr), flag(false)
+    Node* find_node(const key_type& key, size_type hash) const
+    {
+        for(Node* current = buckets[index_of(hash)]; current; current = current->chain_next)
         {
-            if(other.data != nullptr)
-            {
-                data = new value_type(*other.data);
-                flag = true;
-            }
+            if(current->hash == hash && current->key == key)
+                return current;
         }
+        return nullptr;
+    }
 
-        data_wrapper(data_wrapper&& other) noexcept : data(other.data), flag(other.flag) { other.data = nullptr; other.flag = false; }
+    void link_bucket(Node* node)
+    {
+        Node*& head = buckets[index_of(node->hash)];
+        node->chain_prev = nullptr;
+        node->chain_next = head;
+        if(head)
+            head->chain_prev = node;
+        head = node;
+    }
 
-        data_wrapper& operator=(const data_wrapper& other)
-        {
-            if(this == &other)
-                return *this;
+    void unlink_bucket(Node* node)
+    {
+        if(node->chain_prev)
+            node->chain_prev->chain_next = node->chain_next;
+        else
+            buckets[index_of(node->hash)] = node->chain_next;
 
-            delete_data();
+        if(node->chain_next)
+            node->chain_next->chain_prev = node->chain_prev;
+        node->chain_next = node->chain_prev = nullptr;
+    }
 
-            if(other.data != nullptr)
-            {
-                data = new value_type(*other.data);
-                flag = true;
-            }
-            else
-            {
-                data = nullptr;
-                flag = false;
-            }
+    void link_front(Node* node)
+    {
+        node->older = most_recent;
+        node->newer = nullptr;
+        if(most_recent)
+            most_recent->newer = node;
+        most_recent = node;
+        if(!least_recent)
+            least_recent = node;
+    }
 
-            return *this;
-        }
+    void unlink_recency(Node* node)
+    {
+        if(node->newer)
+            node->newer->older = node->older;
+        else
+            most_recent = node->older;
 
-        data_wrapper& operator=(data_wrapper&& other) noexcept
-        {
-            delete_data();
-            data = other.data;
-            flag = other.flag;
-            other.data = nullptr;
-            other.flag = false;
-            return *this;
-        }
+        if(node->older)
+            node->older->newer = node->newer;
+        else
+            least_recent = node->newer;
+        node->newer = node->older = nullptr;
+    }
 
-        void delete_data()
+    void touch(Node* node)
+    {
+        if(node != most_recent)
         {
-            if(data != nullptr)
-            {
-                delete data;
-                data = nullptr;
-            }
+            unlink_recency(node);
+            link_front(node);
         }
+    }
 
-        constexpr void set_data(const_reference value)
-        {
-            if(!data)
-            {
-                data = new value_type(value);
-                flag = true;
-            }
-            else
-            {
-                *data = value;
-            }
-        }
+    void allocate()
+    {
+        // one bucket per entry, rounded up to a power of two
+        table_size = 1;
+        while(table_size < max_size)
+            table_size <<= 1;
 
-        constexpr reference get_data()
-        {
-            return *data;
-        }
+        buckets = new Node*[table_size]();
+        pool = new Node[max_size];
 
-        constexpr const_reference get_data() const
+        free_nodes = nullptr;
+        for(size_type i = max_size; i > 0; --i)
         {
-            return *data;
+            pool[i - 1].chain_next = free_nodes;
+            free_nodes = &pool[i - 1];
         }
+    }
 
-        constexpr void to_blank()
-        {
-            if(data != nullptr)
-            {
-                delete data;
-                data = nullptr;
-            }
-            flag = false;
-        }
+    bool get_hashed(const key_type& key, size_type hash, mapped_type& value)
+    {
+        Node* node = find_node(key, hash);
+        if(!node)
+            return false;
 
-        constexpr bool is_tombstone() const
+        touch(node);
+        value = node->value;
+        return true;
+    }
+
+    bool put_hashed(const key_type& key, size_type hash, const mapped_type& value)
+    {
+        Node* node = find_node(key, hash);
+        if(node)
         {
-            return (data == nullptr && flag == true) ? true : false;
+            node->value = value;
+            touch(node);
+            return false;
         }
 
-        constexpr bool is_blank() const
+        if(free_nodes)
         {
-            return (data == nullptr && flag == false) ? true : false;
+            node = free_nodes;
+            free_nodes = node->chain_next;
+            counter++;
         }
-
-        constexpr bool is_full() const
+        else
         {
-            return (data != nullptr) ? true : false;
+            // at capacity: recycle the least recently used entry
+            node = least_recent;
+            unlink_bucket(node);
+            unlink_recency(node);
         }
-    };
-
- protected:
-    data_wrapper* arr;
-    size_type counter;
 
- public:
-    Hashtable_Probing() : arr(new data_wrapper[N]), counter(0) { static_assert(N != 0, "Size of the table cannot be 0"); }
+        node->key = key;
+        node->value = value;
+        node->hash = hash;
+        link_bucket(node);
+        link_front(node);
+        return true;
+    }
 
-    Hashtable_Probing(std::initializer_list<value_type> value_list) : Hashtable_Probing()
+    size_type erase_hashed(const key_type& key, size_type hash)
     {
-        for(auto&& value : value_list)
-            insert(value);
+        Node* node = find_node(key, hash);
+        if(!node)
+            return 0;
+
+        unlink_bucket(node);
+        unlink_recency(node);
+        node->chain_next = free_nodes;
+        free_nodes = node;
+        counter--;
+        return 1;
     }
 
-    virtual ~Hashtable_Probing()
+ public:
+    explicit LRU_Cache(size_type capacity = N)
+        : buckets(nullptr), pool(nullptr), free_nodes(nullptr), most_recent(nullptr), least_recent(nullptr),
+          max_size((capacity != 0) ? capacity : 1), counter(0), table_size(0)
     {
-        if(arr != nullptr)
-        {
-            delete[] arr;
-            arr = nullptr;
-            counter = 0;
-        }
+        allocate();
     }
 
-    Hashtable_Probing(const Hashtable_Probing& other) : Hashtable_Probing()
+    LRU_Cache(const LRU_Cache& other) : LRU_Cache(other.max_size)
     {
-        for(size_type i = 0; i < N; i++)
-            arr[i] = other.arr[i];
-
-        counter = other.counter;
+        // replay from the oldest entry, so the copy has the same recency order
+        for(Node* current = other.least_recent; current; current = current->newer)
+            put_hashed(current->key, current->hash, current->value);
     }
 
-    Hashtable_Probing(Hashtable_Probing&& other) noexcept : arr(other.arr), counter(other.counter) { other.arr = nullptr; counter = 0; }
+    LRU_Cache(LRU_Cache&& other) noexcept
+        : buckets(other.buckets), pool(other.pool), free_nodes(other.free_nodes), most_recent(other.most_recent),
+          least_recent(other.least_recent), max_size(other.max_size), counter(other.counter), table_size(other.table_size)
+    {
+        other.buckets = nullptr;
+        other.pool = other.free_nodes = other.most_recent = other.least_recent = nullptr;
+        other.counter = 0;
+    }
 
-    Hashtable_Probing& operator=(const Hashtable_Probing& other)
+    LRU_Cache& operator=(const LRU_Cache& other)
     {
         if(this == &other)
             return *this;
 
-        for(size_type i = 0; i < N; i++)
-            arr[i] = other.arr[i];
+        LRU_Cache copy(other);
+        swap(copy);
+        return *this;
+    }
 
-        counter = other.counter;
+    LRU_Cache& operator=(LRU_Cache&& other) noexcept
+    {
+        swap(other);
         return *this;
     }
 
-    Hashtable_Probing& operator=(Hashtable_Probing&& other) noexcept
+    virtual ~LRU_Cache()
     {
-        if(arr != nullptr)
-            delete[] arr;
+        delete[] buckets;
+        delete[] pool;
+    }
 
-        arr = other.arr;
-        counter = other.counter;
-        other.arr = nullptr;
-        other.counter = 0;
-        return *this;
+    void swap(LRU_Cache& other) noexcept
+    {
+        std::swap(buckets, other.buckets);
+        std::swap(pool, other.pool);
+        std::swap(free_nodes, other.free_nodes);
+        std::swap(most_recent, other.most_recent);
+        std::swap(least_recent, other.least_recent);
+        std::swap(max_size, other.max_size);
+        std::swap(counter, other.counter);
+        std::swap(table_size, other.table_size);
     }
 
-    void clear()
+    // copy the cached value into value and mark the entry as most recently used
+    bool get(const key_type& key, mapped_type& value)
+    {
+        return get_hashed(key, this->Full_Hash(key), value);
+    }
+
+    // look up an entry without changing its recency
+    bool contains(const key_type& key) const
+    {
+        return (find_node(key, this->Full_Hash(key)) != nullptr) ? true : false;
+    }
+
+    // true when a new entry was created, false when an existing one was updated
+    bool put(const key_type& key, const mapped_type& value)
+    {
+        return put_hashed(key, this->Full_Hash(key), value);
+    }
+
+    size_type erase(const key_type& key)
     {
-        for(size_type i = 0; i < N; i++)
-            arr[i].to_blank();
+        return erase_hashed(key, this->Full_Hash(key));
+    }
 
+    void clear() override
+    {
+        while(least_recent)
+        {
+            Node* node = least_recent;
+            unlink_bucket(node);
+            unlink_recency(node);
+            node->chain_next = free_nodes;
+            free_nodes = node;
+        }
         counter = 0;
     }
 
-    size_type count() const
+    size_type size() const
     {
         return counter;
     }
 
-    size_type size() const
+    size_type capacity() const
     {
-        return N;
+        return max_size;
     }
 
     bool empty() const
@@ -819,140 +4270,125 @@ class Hashtable_Probing : public Hashing<_Tp, N>
 
     bool full() const
     {
-        return (counter == N) ? true : false;
+        return (counter == max_size) ? true : false;
     }
 
-    bool insert(const_reference value)
+    // entries from the most to the least recently used
+    void display(std::ostream& out) const
     {
-        // If the table is already fulfilled, do nothing
-        if(this->full())
-            return false;
+        for(Node* current = most_recent; current; current = current->older)
+            out << current->key << ": " << current->value << "\n";
+    }
 
-        size_type tomb_note = npos;
-        size_type search_counter = 0;
-        size_type index = this->Hash_Function(value);
+    void display() const
+    {
+        display(std::cout);
+    }
+};
 
-        while(!arr[index].is_blank() && search_counter != N)
-        {
-            // If an entry with this value is already exist, don't attempt to insert anymore
-            if(arr[index].is_full() && arr[index].get_data() == value)
-            {
-                break;
-            }
-            // If a tombstone is found, store this tombstone entry
-            else if(arr[index].is_tombstone() && tomb_note == npos)
-            {
-                tomb_note = index;
-            }
+// LRU_Cache split into independently locked shards for concurrent use. The capacity is divided
+// evenly, so eviction is least-recently-used per shard rather than across the whole cache.
+template<typename _Key, typename _Val, std::size_t Shards = 16, std::size_t N = 100>
+class Sharded_LRU_Cache : public Hashing<_Key, N>
+{
+ public:
+    using key_type = _Key;
+    using mapped_type = _Val;
+    using size_type = std::size_t;
 
-            search_counter++;
-            index = (index + 1) % N;
-        }
+ private:
+    // each shard is a separate allocation, so their locks do not share a cache line
+    struct shard
+    {
+        std::mutex lock;
+        LRU_Cache<_Key, _Val, N> cache;
 
-        if(!arr[index].is_blank() && search_counter != N)
-        {
-            return false;
-        }
-        else if(arr[index].is_blank() && tomb_note != npos && search_counter != N)
-        {
-            arr[tomb_note].set_data(value);
-            counter++;
-            return true;
-        }
-        else if(arr[index].is_blank() && tomb_note == npos && search_counter != N)
-        {
-            arr[index].set_data(value);
-            counter++;
-            return true;
-        }
-        else
-        {
-            arr[tomb_note].set_data(value);
-            counter++;
-            return true;
-        }
+        explicit shard(size_type capacity) : lock(), cache(capacity) {}
+    };
+
+    shard* shards[Shards];
+
+    // the shard is picked from the high bits of a Fibonacci product, the bucket inside a shard from
+    // the low bits of the mixed hash, so the two choices stay independent
+    static size_type shard_of(size_type hash)
+    {
+        return static_cast<size_type>((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 32) % Shards;
     }
 
-    bool search(const_reference value) const
+ public:
+    explicit Sharded_LRU_Cache(size_type capacity = N * Shards)
     {
-        // search_counter is used to avoid infinite loop
-        size_type search_counter = 0;
+        static_assert(Shards != 0, "Number of shards can not be zero!");
+        size_type per_shard = (capacity + Shards - 1) / Shards;
+        for(size_type i = 0; i < Shards; ++i)
+            shards[i] = new shard(per_shard);
+    }
 
-        size_type index = this->Hash_Function(value);
-        while(!arr[index].is_blank() && search_counter != N)
-        {
-            // If an entry with this value is found, stop traversing
-            if(arr[index].is_full() && arr[index].get_data() == value)
-                break;
+    Sharded_LRU_Cache(const Sharded_LRU_Cache&) = delete;
+    Sharded_LRU_Cache& operator=(const Sharded_LRU_Cache&) = delete;
 
-            index = (index + 1) % N;
-            search_counter++;
-        }
+    virtual ~Sharded_LRU_Cache()
+    {
+        for(size_type i = 0; i < Shards; ++i)
+            delete shards[i];
+    }
 
-        // false when the fulfilled table does not contain the value
-        if(search_counter == N)
-        {
-            return false;
-        }
-        // false when stop at blank wrapper
-        else if(search_counter != N && arr[index].is_blank())
-        {
-            return false;
-        }
-        // otherwise, if the current index is a full entry, the value is found
-        else
-        {
-            return true;
-        }
+    bool get(const key_type& key, mapped_type& value)
+    {
+        size_type hash = this->Full_Hash(key);
+        shard& target = *shards[shard_of(hash)];
+        std::lock_guard<std::mutex> guard(target.lock);
+        return target.cache.get_hashed(key, hash, value);
     }
 
-    size_type erase(const_reference value)
+    bool contains(const key_type& key)
     {
-        // search_counter is used to avoid infinite loop
-        size_type search_counter = 0;
+        size_type hash = this->Full_Hash(key);
+        shard& target = *shards[shard_of(hash)];
+        std::lock_guard<std::mutex> guard(target.lock);
+        return (target.cache.find_node(key, hash) != nullptr) ? true : false;
+    }
 
-        size_type index = this->Hash_Function(value);
-        while(!arr[index].is_blank() && search_counter != N)
-        {
-            // If an entry with this value is found, stop traversing
-            if(arr[index].is_full() && arr[index].get_data() == value)
-                break;
+    bool put(const key_type& key, const mapped_type& value)
+    {
+        size_type hash = this->Full_Hash(key);
+        shard& target = *shards[shard_of(hash)];
+        std::lock_guard<std::mutex> guard(target.lock);
+        return target.cache.put_hashed(key, hash, value);
+    }
 
-            index = (index + 1) % N;
-            search_counter++;
-        }
+    size_type erase(const key_type& key)
+    {
+        size_type hash = this->Full_Hash(key);
+        shard& target = *shards[shard_of(hash)];
+        std::lock_guard<std::mutex> guard(target.lock);
+        return target.cache.erase_hashed(key, hash);
+    }
 
-        // do nothing when the fulfilled table does not contain the value
-        if(search_counter == N)
-        {
-            return 0;
-        }
-        // do nothing when stop at blank wrapper
-        else if(search_counter != N && arr[index].is_blank())
-        {
-            return 0;
-        }
-        // otherwise, this is the entry to be deleted
-        else
+    void clear() override
+    {
+        for(size_type i = 0; i < Shards; ++i)
         {
-            arr[index].delete_data();
-            counter--;
-            return 1;
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            shards[i]->cache.clear();
         }
     }
 
-    void display(std::ostream& out) const
+    // a snapshot only: other threads may change the shards while they are counted
+    size_type size()
     {
-        for(size_type i = 0; i < N; i++)
+        size_type total = 0;
+        for(size_type i = 0; i < Shards; ++i)
         {
-            if(arr[i].is_full())
-                out << "Entry #" << i + 1 << ":  " << arr[i].get_data() << "\n";
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            total += shards[i]->cache.size();
         }
+        return total;
     }
 
-    void display() const
+    size_type capacity() const
     {
-        return display(std::cout);
+        return shards[0]->cache.capacity() * Shards;
     }
 };
 }
@@ -0,0 +1,935 @@
+// Behavioural checks for the tables in Hashtable_.hpp. Build and run, e.g.
+//     g++ -std=c++14 -pthread Hashtable_features_test.cpp -o features_test && ./features_test
+// Every failed check is reported on stderr and makes the exit code non-zero.
+#include <iostream>
+#include <string>
+#include <set>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <random>
+#include <sstream>
+#include <iterator>
+#include "Hashtable_.hpp"
+
+using namespace std;
+using namespace Hashtable;
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { if(!(condition)) { cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; failures++; } } while(0)
+
+// key whose hash computations and comparisons are counted
+struct Counted_Key
+{
+    static int hashes;
+    static int compares;
+
+    int value;
+
+    explicit operator std::size_t() const
+    {
+        hashes++;
+        return static_cast<std::size_t>(value);
+    }
+
+    bool operator==(const Counted_Key& other) const
+    {
+        compares++;
+        return value == other.value;
+    }
+
+    static void reset()
+    {
+        hashes = compares = 0;
+    }
+};
+
+// An input iterator whose copies all share one cursor, like a generator: advancing any copy
+// overwrites the value that the others return.
+struct Shared_Cursor
+{
+    using iterator_category = std::input_iterator_tag;
+    using value_type = string;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const string*;
+    using reference = const string&;
+
+    struct Source
+    {
+        const vector<string>* items;
+        std::size_t position;
+        string current;
+    };
+
+    Source* state;
+
+    const string& operator*() const
+    {
+        return state->current;
+    }
+
+    Shared_Cursor& operator++()
+    {
+        state->position++;
+        state->current = (state->position < state->items->size()) ? (*state->items)[state->position] : string("<overwritten>");
+        return *this;
+    }
+
+    bool operator==(const Shared_Cursor& other) const
+    {
+        return at_end() == other.at_end();
+    }
+
+    bool operator!=(const Shared_Cursor& other) const
+    {
+        return !(*this == other);
+    }
+
+    bool at_end() const
+    {
+        return state == nullptr || state->position >= state->items->size();
+    }
+};
+
+int Counted_Key::hashes = 0;
+int Counted_Key::compares = 0;
+
+ostream& operator<<(ostream& out, const Counted_Key& key)
+{
+    return out << key.value;
+}
+
+// keys are compared only when their stored hashes match, and resizing never rehashes
+static void test_stored_hashes()
+{
+    Hashtable_Chaining<Counted_Key, 1> chained;
+    for(int i = 0; i < 50; i++)
+        chained.insert(Counted_Key{i});
+
+    Counted_Key::reset();
+    CHECK(!chained.search(Counted_Key{1000}));
+    CHECK(Counted_Key::compares == 0);
+    CHECK(chained.search(Counted_Key{25}));
+    CHECK(Counted_Key::compares == 1);
+
+    Counted_Key::reset();
+    chained.reserve(500);
+    CHECK(Counted_Key::hashes == 0);
+    CHECK(chained.bucket_count() == 500);
+    for(int i = 0; i < 50; i++)
+        CHECK(chained.search(Counted_Key{i}));
+
+    Hashtable_Probing<Counted_Key, 64> probed;
+    for(int i = 0; i < 40; i++)
+        probed.insert(Counted_Key{i * 64});
+
+    Counted_Key::reset();
+    probed.reserve(1000);
+    CHECK(Counted_Key::hashes == 0);
+    for(int i = 0; i < 40; i++)
+        CHECK(probed.search(Counted_Key{i * 64}));
+    CHECK(!probed.search(Counted_Key{1}));
+}
+
+// no false negatives, a false positive rate near the target, and erase that really forgets
+static void test_bloom_filter()
+{
+    Blocked_Bloom_Filter filter(10000, 0.01);
+    for(std::size_t i = 0; i < 10000; i++)
+        filter.insert(i * 7919);
+    for(std::size_t i = 0; i < 10000; i++)
+        CHECK(filter.may_contain(i * 7919));
+
+    std::size_t false_positives = 0;
+    for(std::size_t i = 0; i < 100000; i++)
+        false_positives += filter.may_contain(i * 7919 + 1) ? 1 : 0;
+    CHECK(false_positives < 3000);
+
+    for(std::size_t i = 0; i < 10000; i++)
+        filter.erase(i * 7919);
+    std::size_t left = 0;
+    for(std::size_t i = 0; i < 10000; i++)
+        left += filter.may_contain(i * 7919) ? 1 : 0;
+    CHECK(left == 0);
+
+    // a filtered table stays exact through erase and copies, and only compares keys on hits
+    Hashtable_Chaining<Counted_Key, 1> table;
+    table.enable_filter(0.001, 1000);
+    CHECK(table.has_filter());
+    for(int i = 0; i < 1000; i++)
+        table.insert(Counted_Key{i});
+    for(int i = 0; i < 500; i++)
+        table.erase(Counted_Key{i});
+
+    Counted_Key::reset();
+    int found = 0;
+    for(int i = 0; i < 1000; i++)
+        found += table.search(Counted_Key{i}) ? 1 : 0;
+    CHECK(found == 500);
+    CHECK(Counted_Key::compares == 500);
+
+    Hashtable_Chaining<Counted_Key, 1> copy(table);
+    CHECK(copy.has_filter());
+    CHECK(copy.search(Counted_Key{700}) && !copy.search(Counted_Key{300}));
+
+    Hashtable_Probing<int, 2000> probed;
+    probed.enable_filter();
+    for(int i = 0; i < 1000; i++)
+        probed.insert(i);
+    probed.erase(10);
+    CHECK(!probed.search(10) && probed.search(11));
+    probed.disable_filter();
+    CHECK(!probed.has_filter() && probed.search(999));
+}
+
+// the least recently used entry is evicted at capacity, and get refreshes an entry
+static void test_lru_cache()
+{
+    LRU_Cache<int, string> cache(3);
+    CHECK(cache.capacity() == 3);
+    CHECK(cache.put(1, "one") && cache.put(2, "two") && cache.put(3, "three"));
+    CHECK(!cache.put(2, "TWO"));
+
+    string value;
+    CHECK(cache.get(1, value) && value == "one");
+    CHECK(cache.put(4, "four"));
+    CHECK(cache.size() == 3);
+    CHECK(!cache.contains(3));
+    CHECK(cache.contains(1) && cache.contains(2) && cache.contains(4));
+
+    // contains does not refresh, so 2 is now the oldest
+    CHECK(cache.put(5, "five"));
+    CHECK(!cache.contains(2));
+    CHECK(cache.get(4, value) && value == "four");
+
+    // the copy keeps the recency order: 1 is the oldest in both
+    LRU_Cache<int, string> copy(cache);
+    copy.put(6, "six");
+    cache.put(6, "six");
+    CHECK(!copy.contains(1) && !cache.contains(1));
+    CHECK(copy.contains(5) && copy.contains(4));
+
+    CHECK(cache.erase(6) == 1 && cache.erase(6) == 0);
+    CHECK(cache.size() == 2);
+    cache.clear();
+    CHECK(cache.size() == 0 && !cache.contains(5));
+
+    // large capacities keep working after the whole key space has cycled through
+    LRU_Cache<int, int> large(100000);
+    for(int i = 0; i < 150000; i++)
+        large.put(i, i);
+    int number = 0;
+    CHECK(large.size() == 100000);
+    CHECK(!large.contains(49999) && large.get(50000, number) && number == 50000);
+
+    Sharded_LRU_Cache<int, int, 4> sharded(400);
+    for(int i = 0; i < 1000; i++)
+        sharded.put(i, i * 2);
+    CHECK(sharded.size() <= sharded.capacity());
+    CHECK(sharded.get(999, number) && number == 1998);
+    CHECK(!sharded.contains(0));
+}
+
+// duplicates are grouped into one node with a count
+static void test_multiset()
+{
+    Hashtable_Multiset<int> events;
+    CHECK(events.insert(5, 3) == 3);
+    CHECK(events.insert(5) == 4);
+    for(int i = 0; i < 10000; i++)
+        events.insert(i % 10);
+
+    CHECK(events.count(5) == 1004);
+    CHECK(events.count(7) == 1000);
+    CHECK(events.count(42) == 0);
+    CHECK(events.size() == 10004);
+    CHECK(events.distinct() == 10);
+
+    auto range = events.equal_range(7);
+    CHECK(std::distance(range.first, range.second) == 1000);
+    bool all_seven = true;
+    for(auto it = range.first; it != range.second; ++it)
+        all_seven = all_seven && *it == 7;
+    CHECK(all_seven);
+    range = events.equal_range(42);
+    CHECK(range.first == range.second);
+
+    // a sorted batch collapses runs of equal keys
+    std::multiset<int> batch;
+    for(int i = 0; i < 3000; i++)
+        batch.insert(100 + i % 3);
+    events.insert(batch.begin(), batch.end());
+    CHECK(events.count(101) == 1000);
+
+    CHECK(events.erase(7, 400) == 400);
+    CHECK(events.count(7) == 600);
+    CHECK(events.erase(7) == 600);
+    CHECK(!events.search(7) && events.distinct() == 12);
+
+    Hashtable_Multiset<string> words = {"a", "b", "a"};
+    CHECK(words.count("a") == 2 && words.size() == 3);
+    Hashtable_Multiset<string> copy(words);
+    words.clear();
+    CHECK(words.empty() && copy.count("a") == 2);
+
+    // a single-pass input range is read once, key by key
+    istringstream input("apple apple pear plum plum plum apple");
+    Hashtable_Multiset<string> streamed;
+    streamed.insert(istream_iterator<string>(input), istream_iterator<string>());
+    CHECK(streamed.count("apple") == 3 && streamed.count("pear") == 1 && streamed.count("plum") == 3);
+    CHECK(streamed.size() == 7 && streamed.distinct() == 3);
+
+    vector<string> source{"x", "x", "y", "x", "z", "z"};
+    Shared_Cursor::Source state{&source, 0, source.front()};
+    Hashtable_Multiset<string> read_once;
+    read_once.insert(Shared_Cursor{&state}, Shared_Cursor{nullptr});
+    CHECK(read_once.count("x") == 3 && read_once.count("y") == 1 && read_once.count("z") == 2);
+}
+
+// integral keys live in a flat array; the two sentinel values are still storable via side slots
+static void test_integral_probing()
+{
+    Hashtable_Probing<long, 64> table;
+    const long empty = table.empty_value();
+    const long deleted = table.deleted_value();
+    CHECK(empty != deleted);
+
+    CHECK(table.insert(empty) && table.insert(deleted));
+    CHECK(!table.insert(empty));
+    CHECK(table.count() == 2);
+    CHECK(table.search(empty) && table.search(deleted));
+
+    for(long i = 0; i < 40; i++)
+        table.insert(i);
+    CHECK(table.count() == 42);
+
+    // the sentinels take no slot of the array: 64 ordinary keys still fit next to them
+    for(long i = 40; i < 64; i++)
+        CHECK(table.insert(i));
+    CHECK(table.count() == 66);
+
+    CHECK(table.erase(empty) == 1 && table.erase(empty) == 0);
+    CHECK(!table.search(empty) && table.search(deleted));
+    CHECK(table.erase(5) == 1 && !table.search(5));
+    CHECK(table.insert(5) && table.search(5));
+    table.clear();
+    CHECK(table.count() == 0 && !table.search(deleted) && !table.search(5));
+
+    Hashtable_Probing<int, 16> custom(-1, -2);
+    CHECK(custom.insert(0) && custom.insert(-1) && custom.insert(-2));
+    CHECK(custom.search(-1) && custom.search(-2) && custom.search(0) && !custom.search(-3));
+
+    bool rejected = false;
+    try
+    {
+        Hashtable_Probing<int, 16> invalid(7, 7);
+    }
+    catch(const std::invalid_argument&)
+    {
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+template<typename Table, typename Key>
+static bool holds_exactly(Table& table, const std::set<int>& expected, Key key, int universe)
+{
+    for(int i = 0; i < universe; i++)
+    {
+        if(table.search(key(i)) != (expected.count(i) == 1))
+            return false;
+    }
+    return true;
+}
+
+template<typename Table, typename Key>
+static void check_set_algebra(Key key, std::size_t threads)
+{
+    const int universe = 3000;
+    std::set<int> first_keys, second_keys, expected;
+    Table first, second;
+    first.reserve(2 * universe);
+    second.reserve(2 * universe);
+    for(int i = 0; i < universe; i += 2)
+    {
+        first.insert(key(i));
+        first_keys.insert(i);
+    }
+    for(int i = 0; i < universe; i += 3)
+    {
+        second.insert(key(i));
+        second_keys.insert(i);
+    }
+
+    Table united = Table::union_of(first, second, threads);
+    expected = first_keys;
+    expected.insert(second_keys.begin(), second_keys.end());
+    CHECK(holds_exactly(united, expected, key, universe));
+
+    Table merged(first);
+    CHECK(merged.merge(second, threads) == expected.size() - first_keys.size());
+    CHECK(holds_exactly(merged, expected, key, universe));
+
+    Table common(first);
+    CHECK(common.intersect_with(second, threads) == first_keys.size() - universe / 6);
+    expected.clear();
+    for(int i = 0; i < universe; i += 6)
+        expected.insert(i);
+    CHECK(holds_exactly(common, expected, key, universe));
+
+    Table only_first(first);
+    CHECK(only_first.difference(second, threads) == std::size_t(universe / 6));
+    expected.clear();
+    for(int i : first_keys)
+    {
+        if(i % 3 != 0)
+            expected.insert(i);
+    }
+    CHECK(holds_exactly(only_first, expected, key, universe));
+    CHECK(holds_exactly(first, first_keys, key, universe) && holds_exactly(second, second_keys, key, universe));
+}
+
+// merge, intersection, difference and union agree with std::set, single and multi-threaded
+static void test_set_operations()
+{
+    auto number = [](int i) { return i; };
+    auto text = [](int i) { return to_string(i); };
+    for(std::size_t threads : {1, 4})
+    {
+        check_set_algebra<Hashtable_Chaining<int, 64>>(number, threads);
+        check_set_algebra<Hashtable_Chaining<string, 64>>(text, threads);
+        check_set_algebra<Hashtable_Probing<string, 64>>(text, threads);
+        check_set_algebra<Hashtable_Probing<int, 64>>(number, threads);
+    }
+}
+
+// memory_usage tracks the contents, reserve/shrink_to_fit resize, and a budget is enforced
+static void test_memory_control()
+{
+    Hashtable_Chaining<string, 16> chained;
+    std::size_t empty_bytes = chained.memory_usage();
+    for(int i = 0; i < 1000; i++)
+        chained.insert(string(100, 'k') + to_string(i));
+    CHECK(chained.memory_usage() > empty_bytes + 1000 * 100);
+
+    chained.reserve(2000);
+    CHECK(chained.bucket_count() == 2000);
+    chained.shrink_to_fit();
+    CHECK(chained.bucket_count() == 1000);
+    CHECK(chained.search(string(100, 'k') + "999"));
+
+    Hashtable_Probing<string, 16> probed;
+    probed.reserve(300);
+    CHECK(probed.size() >= 400);
+    for(int i = 0; i < 300; i++)
+        CHECK(probed.insert(to_string(i)));
+    for(int i = 0; i < 250; i++)
+        probed.erase(to_string(i));
+    probed.shrink_to_fit();
+    CHECK(probed.size() < 100 && probed.count() == 50);
+    CHECK(probed.search("299") && !probed.search("0"));
+
+    // small requests round up, so the load stays at or below 3/4 and a shrunk table has a free slot
+    bool three_quarters = true;
+    for(std::size_t n = 1; n <= 50; n++)
+    {
+        Hashtable_Probing<string, 1> generic;
+        Hashtable_Probing<int, 1> integral;
+        generic.reserve(n);
+        integral.reserve(n);
+        three_quarters = three_quarters && 3 * generic.size() >= 4 * n && 3 * integral.size() >= 4 * n;
+    }
+    CHECK(three_quarters);
+    Hashtable_Probing<int, 16> pair{1, 2};
+    pair.shrink_to_fit();
+    CHECK(pair.size() == 3 && pair.insert(3) && pair.search(1) && pair.search(2));
+    Hashtable_Probing<string, 16> text_pair{"1", "2"};
+    text_pair.shrink_to_fit();
+    CHECK(text_pair.size() == 3 && text_pair.insert("3"));
+
+    Budget_Resource budget(64 * 1024);
+    {
+        Hashtable_Probing<int, 100> limited(&budget);
+        CHECK(budget.bytes_used() > 0);
+        bool refused = false;
+        try
+        {
+            limited.reserve(100000);
+        }
+        catch(const std::bad_alloc&)
+        {
+            refused = true;
+        }
+        CHECK(refused);
+
+        // a refused resize leaves the table usable
+        CHECK(limited.insert(1) && limited.search(1));
+    }
+    CHECK(budget.bytes_used() == 0);
+
+    // chained nodes and keys are taken from the budget as well; with short buckets everything but
+    // the table object and the segment bookkeeping is then charged to it
+    Budget_Resource chained_budget(256 * 1024);
+    {
+        Hashtable_Chaining<int, 4096> limited(&chained_budget);
+        int inserted = 0;
+        try
+        {
+            for(; inserted < 100000; inserted++)
+                limited.insert(inserted);
+        }
+        catch(const std::bad_alloc&)
+        {
+        }
+        CHECK(inserted < 100000 && static_cast<int>(limited.size()) == inserted);
+        CHECK(chained_budget.bytes_used() <= chained_budget.budget());
+        CHECK(limited.memory_usage() - chained_budget.bytes_used() < 1024);
+        CHECK(limited.search(0) && limited.erase(0) == 1 && limited.insert(0));
+    }
+    CHECK(chained_budget.bytes_used() == 0);
+
+    // nodes moved to a table with another resource are charged to that resource
+    Budget_Resource first_budget(1 << 20), second_budget(1 << 20);
+    {
+        Hashtable_Chaining<string, 64> first(&first_budget), second(&second_budget);
+        for(int i = 0; i < 100; i++)
+            first.insert(to_string(i));
+        std::size_t first_bytes = first_budget.bytes_used();
+        std::size_t second_bytes = second_budget.bytes_used();
+
+        CHECK(second.insert(first.extract("7")) && second.search("7") && !first.search("7"));
+        CHECK(second.splice_from(first) == 99 && first.size() == 0);
+        CHECK(first_budget.bytes_used() < first_bytes && second_budget.bytes_used() > second_bytes);
+        CHECK(first_budget.bytes_used() + second_budget.bytes_used() == first_bytes + second_bytes);
+
+        // copy assignment across resources builds the nodes in the table's own resource
+        Hashtable_Chaining<string, 64> copy(&first_budget);
+        std::size_t before = second_budget.bytes_used();
+        copy = second;
+        CHECK(second_budget.bytes_used() == before && copy.size() == 100 && copy.search("42"));
+        second.clear();
+        CHECK(copy.search("7") && copy.search("99"));
+    }
+    CHECK(first_budget.bytes_used() == 0 && second_budget.bytes_used() == 0);
+}
+
+// a frozen table answers exactly like its source and is independent of it
+static void test_freeze()
+{
+    Hashtable_Chaining<string, 8> source;
+    for(int i = 0; i < 2000; i++)
+        source.insert("key" + to_string(i));
+
+    Frozen_Hashtable<string, 8> frozen = source.freeze();
+    CHECK(frozen.size() == 2000 && !frozen.empty());
+    CHECK(frozen.bucket_count() == 2000);
+
+    bool same = true;
+    for(int i = 0; i < 2500; i++)
+        same = same && frozen.search("key" + to_string(i)) == (i < 2000);
+    CHECK(same);
+
+    source.erase("key1");
+    source.insert("late");
+    CHECK(frozen.search("key1") && !frozen.search("late"));
+
+    Hashtable_Chaining<int, 8> empty_source;
+    Frozen_Hashtable<int, 8> empty_frozen = empty_source.freeze();
+    CHECK(empty_frozen.empty() && !empty_frozen.search(0));
+}
+
+// interleaved batch lookups give the same answers as one search at a time
+template<typename Table>
+static void check_search_batch(Table& table, const vector<int>& queries)
+{
+    unique_ptr<bool[]> found(new bool[queries.size()]);
+    for(std::size_t group : {1, 3, 16, 100})
+    {
+        std::size_t hits = table.search_batch(queries.data(), queries.size(), found.get(), group);
+        std::size_t expected_hits = 0;
+        bool same = true;
+        for(std::size_t i = 0; i < queries.size(); i++)
+        {
+            bool expected = table.search(queries[i]);
+            expected_hits += expected ? 1 : 0;
+            same = same && found[i] == expected;
+        }
+        CHECK(same && hits == expected_hits);
+    }
+}
+
+static void test_search_batch()
+{
+    vector<int> queries;
+    for(int i = 0; i < 3000; i++)
+        queries.push_back((i * 7) % 4000);
+
+    Hashtable_Chaining<int, 256> table;
+    for(int i = 0; i < 2000; i++)
+        table.insert(i);
+    check_search_batch(table, queries);
+
+    table.enable_filter();
+    check_search_batch(table, queries);
+
+    // a single bucket holds everything, so every lookup walks a long (treeified) chain
+    Hashtable_Chaining<int, 1> crowded;
+    for(int i = 0; i < 500; i++)
+        crowded.insert(i * 3);
+    check_search_batch(crowded, queries);
+
+    check_search_batch(crowded, vector<int>());
+}
+
+// large arrays are mapped by the huge page resource, small ones go upstream, nothing leaks
+static void test_huge_page_resource()
+{
+    Budget_Resource upstream(1 << 20);
+    for(auto pages : {Huge_Page_Resource::Pages::normal, Huge_Page_Resource::Pages::transparent, Huge_Page_Resource::Pages::explicit_huge})
+    {
+        Huge_Page_Resource huge(pages, Huge_Page_Resource::Numa::local, 0, 64 * 1024, &upstream);
+        {
+            Hashtable_Probing<int, 100000> large(&huge);
+            Hashtable_Probing<int, 100> small(&huge);
+            for(int i = 0; i < 50000; i++)
+                large.insert(i);
+            small.insert(1);
+            CHECK(large.search(49999) && small.search(1));
+            CHECK(upstream.bytes_used() > 0);
+#if defined(__linux__)
+            CHECK(huge.bytes_mapped() >= 100000 * sizeof(int));
+            CHECK(huge.bytes_mapped() % Huge_Page_Resource::huge_page_size == 0);
+#endif
+        }
+        CHECK(huge.bytes_mapped() == 0);
+        CHECK(upstream.bytes_used() == 0);
+    }
+}
+
+template<typename Table, typename Key>
+static void check_snapshot(Key key)
+{
+    Table original;
+    original.reserve(4000);
+    for(int i = 0; i < 2000; i++)
+        original.insert(key(i));
+
+    Table snapshot(original);
+    // read and finally destroy a second snapshot on another thread while the original changes
+    Table* shared = new Table(original);
+    bool reader_saw_all = true;
+    thread reader([&]() {
+        for(int round = 0; round < 5; round++)
+            for(int i = 0; i < 2000; i++)
+                reader_saw_all = reader_saw_all && shared->search(key(i));
+        delete shared;
+    });
+
+    for(int i = 0; i < 1000; i++)
+        original.erase(key(i));
+    for(int i = 2000; i < 3000; i++)
+        original.insert(key(i));
+    reader.join();
+
+    CHECK(reader_saw_all);
+    bool unchanged = true;
+    for(int i = 0; i < 3000; i++)
+        unchanged = unchanged && snapshot.search(key(i)) == (i < 2000);
+    CHECK(unchanged);
+    bool modified = true;
+    for(int i = 0; i < 3000; i++)
+        modified = modified && original.search(key(i)) == (i >= 1000);
+    CHECK(modified);
+
+    snapshot.clear();
+    CHECK(!snapshot.search(key(1500)) && original.search(key(1500)));
+}
+
+// copies are O(1) snapshots that share memory until either side writes
+static void test_copy_on_write()
+{
+    auto number = [](int i) { return i; };
+    auto text = [](int i) { return to_string(i); };
+    check_snapshot<Hashtable_Chaining<string, 64>>(text);
+    check_snapshot<Hashtable_Probing<string, 64>>(text);
+    check_snapshot<Hashtable_Probing<int, 64>>(number);
+
+    Budget_Resource budget(1 << 22);
+    Hashtable_Probing<int, 100000> table(&budget);
+    std::size_t one_array = budget.bytes_used();
+    table.insert(1);
+    {
+        Hashtable_Probing<int, 100000> copy(table);
+        CHECK(budget.bytes_used() == one_array);
+
+        // the first write copies one segment, not the whole array
+        table.insert(2);
+        CHECK(budget.bytes_used() > one_array && budget.bytes_used() <= one_array + 64 * 1024);
+        CHECK(copy.search(1) && !copy.search(2));
+    }
+
+    // clearing an unshared table needs no second array, even with no budget to spare
+    Budget_Resource tight(one_array);
+    Hashtable_Probing<int, 100000> exact(&tight);
+    exact.insert(7);
+    exact.clear();
+    CHECK(!exact.search(7) && exact.count() == 0);
+
+    // copy assignment keeps the table's own resource
+    Budget_Resource other_budget(1 << 22);
+    Hashtable_Probing<int, 100000> assigned(&other_budget);
+    std::size_t before = budget.bytes_used();
+    assigned = table;
+    CHECK(budget.bytes_used() == before && other_budget.bytes_used() == one_array);
+    CHECK(assigned.search(1) && assigned.search(2));
+}
+
+// every table draws its own seed unless given one, and a single bucket indexes itself past 8 nodes
+static void test_seeded_buckets()
+{
+    Hashtable_Chaining<int, 64> first, second;
+    CHECK(first.hash_seed() != second.hash_seed());
+    Hashtable_Chaining<int, 64> third(Memory_Resource::default_resource(), first.hash_seed());
+    CHECK(third.hash_seed() == first.hash_seed());
+
+    // with one bucket every key collides; memory_usage() shows when the index appears
+    Hashtable_Chaining<int, 1> bucket;
+    vector<size_t> grown{bucket.memory_usage()};
+    for(int i = 0; i < 9; i++){
+        bucket.insert(i);
+        grown.push_back(bucket.memory_usage());
+    }
+    size_t per_node = grown[1] - grown[0];
+    bool linear_before = true;
+    for(int i = 1; i <= 8; i++)
+        linear_before = linear_before && grown[i] - grown[i - 1] == per_node;
+    CHECK(linear_before);
+    CHECK(grown[9] - grown[8] > per_node);
+
+    bucket.erase(8);
+    CHECK(bucket.memory_usage() > grown[8]);
+    bucket.erase(7);
+    CHECK(bucket.memory_usage() > grown[7]);
+    bucket.erase(6);
+    CHECK(bucket.memory_usage() == grown[6]);
+    bool found = true;
+    for(int i = 0; i < 9; i++)
+        found = found && bucket.search(i) == (i < 6);
+    CHECK(found);
+
+    // random operations on an indexed bucket agree with std::set
+    Hashtable_Chaining<int, 1> table;
+    set<int> expected;
+    mt19937 random(37);
+    bool agrees = true;
+    for(int step = 0; step < 20000; step++){
+        int key = static_cast<int>(random() % 64);
+        switch(random() % 3){
+            case 0: table.insert(key); expected.insert(key); break;
+            case 1: table.erase(key); expected.erase(key); break;
+            default: agrees = agrees && table.search(key) == (expected.count(key) == 1);
+        }
+        agrees = agrees && table.size() == expected.size();
+    }
+    CHECK(agrees);
+}
+
+template<typename Table, typename Key>
+static void check_probe_policy(Key key, bool power_of_two)
+{
+    Table table;
+    size_t slots = table.size();
+    CHECK(!power_of_two || (slots & (slots - 1)) == 0);
+    CHECK(slots >= 100);
+
+    // churn leaves tombstones behind; results must still match std::set
+    set<int> expected;
+    mt19937 random(38);
+    bool agrees = true;
+    for(int step = 0; step < 20000; step++){
+        int i = static_cast<int>(random() % 80);
+        switch(random() % 3){
+            case 0:
+                agrees = agrees && table.insert(key(i)) == expected.insert(i).second;
+                break;
+            case 1:
+                agrees = agrees && table.erase(key(i)) == expected.erase(i);
+                break;
+            default:
+                agrees = agrees && table.search(key(i)) == (expected.count(i) == 1);
+        }
+        agrees = agrees && table.count() == expected.size();
+    }
+    CHECK(agrees);
+    CHECK(expected.empty() || table.average_probe_length() >= 1);
+
+    // every policy reaches every slot
+    table.clear();
+    bool filled = true;
+    for(size_t i = 0; i < slots; i++)
+        filled = filled && table.insert(key(static_cast<int>(i)));
+    CHECK(filled && table.full());
+    CHECK(!table.insert(key(static_cast<int>(slots))));
+    bool found = true;
+    for(size_t i = 0; i < slots; i++)
+        found = found && table.search(key(static_cast<int>(i)));
+    CHECK(found);
+}
+
+// keys on a power-of-two stride must still spread over the table
+template<typename Table, typename Key>
+static void check_strided_probes(Key key)
+{
+    Table table;
+    for(int i = 0; i < 2000; i++)
+        table.insert(key(i * 4096));
+    CHECK(table.count() == 2000);
+    CHECK(table.average_probe_length() < 10);
+}
+
+static void test_probe_policies()
+{
+    auto number = [](int i) { return i; };
+    auto text = [](int i) { return to_string(i); };
+    check_probe_policy<Hashtable_Probing<string, 100, Linear_Probing>>(text, false);
+    check_probe_policy<Hashtable_Probing<string, 100, Quadratic_Probing>>(text, true);
+    check_probe_policy<Hashtable_Probing<string, 100, Double_Hashing>>(text, true);
+    check_probe_policy<Hashtable_Probing<int, 100, Linear_Probing>>(number, false);
+    check_probe_policy<Hashtable_Probing<int, 100, Quadratic_Probing>>(number, true);
+    check_probe_policy<Hashtable_Probing<int, 100, Double_Hashing>>(number, true);
+
+    auto counted = [](int i) { return Counted_Key{i}; };
+    check_strided_probes<Hashtable_Probing<int, 4096, Linear_Probing>>(number);
+    check_strided_probes<Hashtable_Probing<int, 4096, Quadratic_Probing>>(number);
+    check_strided_probes<Hashtable_Probing<int, 4096, Double_Hashing>>(number);
+    check_strided_probes<Hashtable_Probing<Counted_Key, 4096, Linear_Probing>>(counted);
+    check_strided_probes<Hashtable_Probing<Counted_Key, 4096, Quadratic_Probing>>(counted);
+    check_strided_probes<Hashtable_Probing<Counted_Key, 4096, Double_Hashing>>(counted);
+}
+
+// nodes move between tables by relinking; a key is rehashed only when the seeds differ
+static void test_node_handles()
+{
+    using Table = Hashtable_Chaining<Counted_Key, 16>;
+    Table source, other_seed;
+    Table same_seed(Memory_Resource::default_resource(), source.hash_seed());
+    for(int i = 0; i < 10; i++)
+        source.insert(Counted_Key{i});
+
+    Table::Node_Handle handle = source.extract(Counted_Key{3});
+    CHECK(!handle.empty() && handle.value().value == 3 && !source.search(Counted_Key{3}));
+    const Counted_Key* node = &handle.value();
+
+    Counted_Key::reset();
+    CHECK(same_seed.insert(std::move(handle)) && handle.empty());
+    CHECK(Counted_Key::hashes == 0);
+    CHECK(same_seed.search(Counted_Key{3}));
+
+    // the same node, moved on to a table with another seed, is rehashed once
+    handle = same_seed.extract(Counted_Key{3});
+    CHECK(&handle.value() == node);
+    Counted_Key::hashes = 0;
+    CHECK(other_seed.insert(std::move(handle)));
+    CHECK(Counted_Key::hashes == 1);
+    handle = other_seed.extract(Counted_Key{3});
+    CHECK(&handle.value() == node && same_seed.insert(std::move(handle)));
+
+    // a duplicate leaves the node with the handle, and an empty handle inserts nothing
+    source.insert(Counted_Key{3});
+    handle = source.extract(Counted_Key{3});
+    CHECK(!same_seed.insert(std::move(handle)) && !handle.empty() && handle.value().value == 3);
+    Table::Node_Handle none = source.extract(Counted_Key{42});
+    CHECK(none.empty() && !same_seed.insert(std::move(none)) && same_seed.size() == 1);
+
+    // splice_from moves only the missing keys; duplicates stay behind and a snapshot of the source is untouched
+    for(int i = 5; i < 8; i++)
+        same_seed.insert(Counted_Key{i});
+    Table snapshot(source);
+    Counted_Key::hashes = 0;
+    CHECK(same_seed.splice_from(source) == 6);
+    CHECK(Counted_Key::hashes == 0);
+    bool merged = true;
+    for(int i = 0; i < 10; i++)
+        merged = merged && same_seed.search(Counted_Key{i}) && source.search(Counted_Key{i}) == (i >= 5 && i < 8);
+    CHECK(merged && source.size() == 3 && same_seed.size() == 10);
+    bool untouched = true;
+    for(int i = 0; i < 10; i++)
+        untouched = untouched && snapshot.search(Counted_Key{i}) == (i != 3);
+    CHECK(untouched && snapshot.size() == 9);
+
+    // across seeds every moved key is rehashed once
+    Table rehashed;
+    Counted_Key::hashes = 0;
+    CHECK(rehashed.splice_from(snapshot) == 9 && snapshot.size() == 0);
+    CHECK(Counted_Key::hashes == 9);
+
+    // merge only ever copies, whatever the value category of its argument
+    Table copied;
+    CHECK(copied.merge(std::move(rehashed), 2) == 9 && rehashed.size() == 9);
+}
+
+// a write after a snapshot clones the slot segment; tombstones must survive the clone
+static void test_snapshot_tombstones()
+{
+    // every multiple of 64 starts probing at slot 0
+    Hashtable_Probing<Counted_Key, 64> table;
+    table.insert(Counted_Key{64});
+    table.insert(Counted_Key{128});
+    table.erase(Counted_Key{64});
+    Hashtable_Probing<Counted_Key, 64> snapshot(table);
+    table.insert(Counted_Key{5});
+    CHECK(table.search(Counted_Key{128}) && snapshot.search(Counted_Key{128}));
+    CHECK(!table.insert(Counted_Key{128}) && table.count() == 2);
+
+    // random churn with snapshots taken along the way
+    Hashtable_Probing<string, 256> churned;
+    set<int> expected;
+    vector<Hashtable_Probing<string, 256>> snapshots;
+    mt19937 random(36);
+    bool agrees = true;
+    for(int step = 0; step < 20000; step++){
+        int i = static_cast<int>(random() % 150);
+        switch(random() % 3){
+            case 0:
+                agrees = agrees && churned.insert(to_string(i)) == expected.insert(i).second;
+                break;
+            case 1:
+                agrees = agrees && churned.erase(to_string(i)) == expected.erase(i);
+                break;
+            default:
+                agrees = agrees && churned.search(to_string(i)) == (expected.count(i) == 1);
+        }
+        if(step % 1000 == 0)
+            snapshots.push_back(churned);
+    }
+    for(int i = 0; i < 150; i++)
+        agrees = agrees && churned.search(to_string(i)) == (expected.count(i) == 1);
+    CHECK(agrees && churned.count() == expected.size());
+}
+
+int main()
+{
+    test_stored_hashes();
+    test_bloom_filter();
+    test_lru_cache();
+    test_multiset();
+    test_integral_probing();
+    test_set_operations();
+    test_memory_control();
+    test_freeze();
+    test_search_batch();
+    test_huge_page_resource();
+    test_copy_on_write();
+    test_seeded_buckets();
+    test_probe_policies();
+    test_node_handles();
+    test_snapshot_tombstones();
+
+    if(failures)
+        cerr << failures << " check(s) failed\n";
+    else
+        cout << "all checks passed\n";
+    return (failures) ? 1 : 0;
+}
@@ -1,6 +1,6 @@
 #include <iostream>
 #include <string>
-#include "Hashtable.hpp"
+#include "Hashtable_.hpp"
 
 using namespace std;
 using namespace Hashtable;